@@ -1,51 +1,27 @@
 #include "particle.hpp"
 #include "shaders.hpp"
-#include <wayfire/core.hpp>
-#include <thread>
+#include "simd.hpp"
+#include <wayfire/thread-pool.hpp>
+#include <algorithm>
 
-void Particle::update(float time)
-{
-    if (life <= 0) // ignore
-    {
-        return;
-    }
-
-    const float slowdown = 0.8;
-
-    pos   += speed * 0.2f * slowdown;
-    speed += g * 0.3f * slowdown;
-
-    if (life != 0)
-    {
-        color.a /= life;
-    }
-
-    life    -= fade * 0.3 * slowdown;
-    radius   = base_radius * std::pow(life, 0.5);
-    color.a *= life;
+/* The movement of a particle in each update */
+static constexpr float SLOWDOWN   = 0.8;
+static constexpr float POS_STEP   = 0.2 * SLOWDOWN;
+static constexpr float SPEED_STEP = 0.3 * SLOWDOWN;
+static constexpr float LIFE_STEP  = 0.3 * SLOWDOWN;
 
-    if (start_pos.x < pos.x)
-    {
-        g.x = -1;
-    } else
-    {
-        g.x = 1;
-    }
+/* Dead particles are moved outside of the visible area */
+static constexpr float DEAD_POS = -10000;
 
-    if (life <= 0)
-    {
-        /* move outside */
-        pos = {-10000, -10000};
-    }
+static int round_up(int x, int mod)
+{
+    return mod * ((x + mod - 1) / mod);
 }
 
 ParticleSystem::ParticleSystem(int particles)
 {
-    resize(particles);
-    last_update_msec = wf::get_current_time();
-    create_program();
-
     particles_alive.store(0);
+    resize(particles);
 }
 
 void ParticleSystem::set_initer(ParticleIniter init)
@@ -55,122 +31,181 @@ void ParticleSystem::set_initer(ParticleIniter init)
 
 ParticleSystem::~ParticleSystem()
 {
-    OpenGL::render_begin();
-    program.free_resources();
-    OpenGL::render_end();
+    if (program.get_program_id(wf::TEXTURE_TYPE_RGBA))
+    {
+        OpenGL::render_begin();
+        program.free_resources();
+        OpenGL::render_end();
+    }
+}
+
+void ParticleSystem::store_particle(int i, const Particle& p)
+{
+    life[i] = p.life;
+    fade[i] = p.fade;
+    base_radius[i] = p.base_radius;
+    radius[i]   = p.radius;
+    center_x[i] = p.pos.x;
+    center_y[i] = p.pos.y;
+    start_x[i]  = p.start_pos.x;
+    speed_x[i]  = p.speed.x;
+    speed_y[i]  = p.speed.y;
+    g_x[i] = p.g.x;
+    g_y[i] = p.g.y;
+
+    for (int j = 0; j < color_per_particle; j++)
+    {
+        color[color_per_particle * i + j] = p.color[j];
+    }
+
+    alpha[i] = p.color.a;
+}
+
+void ParticleSystem::kill_particle(int i)
+{
+    Particle dead{};
+    dead.radius = dead.base_radius = 0;
+    dead.color.a = 0;
+    store_particle(i, dead);
 }
 
 int ParticleSystem::spawn(int num)
 {
-    // TODO: multithread this
     int spawned = 0;
-    for (size_t i = 0; i < ps.size() && spawned < num; i++)
+    while (spawned < num && !free_slots.empty())
     {
-        if (ps[i].life <= 0)
+        Particle particle{};
+        pinit_func(particle);
+        if (particle.life <= 0)
         {
-            pinit_func(ps[i]);
-            ++spawned;
-            ++particles_alive;
+            // Would never be updated, and thus never die
+            break;
         }
+
+        store_particle(free_slots.back(), particle);
+        free_slots.pop_back();
+        ++spawned;
     }
 
+    particles_alive += spawned;
     return spawned;
 }
 
 void ParticleSystem::resize(int num)
 {
-    if (num == (int)ps.size())
+    if (num == num_particles)
     {
         return;
     }
 
-    // TODO: multithread this
-    for (int i = num; i < (int)ps.size(); i++)
+    for (int i = num; i < num_particles; i++)
     {
-        if (ps[i].life >= 0)
+        if (life[i] > 0)
         {
             --particles_alive;
         }
     }
 
-    ps.resize(num);
+    free_slots.erase(std::remove_if(free_slots.begin(), free_slots.end(),
+        [=] (int i) { return i >= num; }), free_slots.end());
+
+    int capacity = round_up(num, simd::WIDTH);
+    for (auto *array : {&life, &fade, &base_radius, &radius, &center_x, &center_y,
+        &start_x, &speed_x, &speed_y, &g_x, &g_y, &alpha})
+    {
+        array->resize(capacity);
+    }
+
+    color.resize(color_per_particle * capacity);
+
+    // New particles are free, and the padding has to be dead as well
+    for (int i = capacity - 1; i >= std::min(num, num_particles); i--)
+    {
+        kill_particle(i);
+        if (i < num)
+        {
+            free_slots.push_back(i);
+        }
+    }
 
-    color.resize(color_per_particle * num);
-    dark_color.resize(color_per_particle * num);
-    radius.resize(radius_per_particle * num);
-    center.resize(center_per_particle * num);
+    num_particles = num;
 }
 
 int ParticleSystem::size()
 {
-    return ps.size();
+    return num_particles;
 }
 
-void ParticleSystem::update_worker(float time, int start, int end)
+void ParticleSystem::update_blocks(int start, int end)
 {
-    end = std::min(end, (int)ps.size());
-    for (int i = start; i < end; ++i)
+    using namespace simd;
+    std::vector<int> died;
+
+    for (int i = start * WIDTH; i < end * WIDTH; i += WIDTH)
     {
-        if (ps[i].life <= 0)
+        f32x4 cur_life = load(&life[i]);
+        auto alive     = cur_life > splat(0);
+        if (!any(alive))
         {
             continue;
         }
 
-        // printf("%d\n", i);
-        ps[i].update(time);
-
-        if (ps[i].life <= 0)
-        {
-            --particles_alive;
-        }
-
-        for (int j = 0; j < 4; j++) // maybe use memcpy?
+        f32x4 pos_x = load(&center_x[i]) + load(&speed_x[i]) * POS_STEP;
+        f32x4 pos_y = load(&center_y[i]) + load(&speed_y[i]) * POS_STEP;
+        f32x4 gx    = load(&g_x[i]);
+        store(&speed_x[i], select(alive, load(&speed_x[i]) + gx * SPEED_STEP,
+            load(&speed_x[i])));
+        store(&speed_y[i], select(alive, load(&speed_y[i]) + load(&g_y[i]) * SPEED_STEP,
+            load(&speed_y[i])));
+
+        f32x4 new_life = cur_life - load(&fade[i]) * LIFE_STEP;
+        // The alpha is proportional to the remaining life
+        f32x4 new_alpha = load(&alpha[i]) / select(alive, cur_life, splat(1)) * new_life;
+        f32x4 new_radius = load(&base_radius[i]) * sqrt(max(new_life, splat(0)));
+
+        // The particles are pulled towards their starting position
+        gx = select(load(&start_x[i]) < pos_x, splat(-1), splat(1));
+
+        auto dying = alive & (new_life <= splat(0));
+        pos_x = select(dying, splat(DEAD_POS), pos_x);
+        pos_y = select(dying, splat(DEAD_POS), pos_y);
+
+        store(&center_x[i], select(alive, pos_x, load(&center_x[i])));
+        store(&center_y[i], select(alive, pos_y, load(&center_y[i])));
+        store(&g_x[i], select(alive, gx, load(&g_x[i])));
+        store(&life[i], select(alive, new_life, cur_life));
+        store(&alpha[i], select(alive, new_alpha, load(&alpha[i])));
+        store(&radius[i], select(alive, new_radius, load(&radius[i])));
+
+        if (any(dying))
         {
-            color[4 * i + j] = ps[i].color[j];
-            dark_color[4 * i + j] = ps[i].color[j] * 0.5;
+            for (int j = 0; j < WIDTH; j++)
+            {
+                if (dying[j])
+                {
+                    died.push_back(i + j);
+                }
+            }
         }
-
-        // printf("center %d gets %f", 2 * i, ps[i].pos[0]);
-        center[2 * i]     = ps[i].pos[0];
-        center[2 * i + 1] = ps[i].pos[1];
-
-        radius[i] = ps[i].radius;
-    }
-}
-
-void ParticleSystem::exec_worker_threads(std::function<void(int, int)> spawn_worker)
-{
-// return spawn_worker(0, ps.size());
-
-    const int num_threads = std::thread::hardware_concurrency();
-    const int worker_load = (ps.size() + num_threads - 1) / num_threads;
-
-    std::thread workers[num_threads];
-    for (int i = 0; i < num_threads; i++)
-    {
-        int thread_start = i * worker_load;
-        int thread_end   = (i + 1) * worker_load;
-        thread_end = std::min(thread_end, (int)ps.size());
-
-        workers[i] = std::thread([=] () { spawn_worker(thread_start, thread_end); });
     }
 
-    for (auto& w : workers)
+    if (!died.empty())
     {
-        w.join();
+        std::lock_guard<std::mutex> lock(free_slots_mutex);
+        free_slots.insert(free_slots.end(), died.begin(), died.end());
+        particles_alive -= died.size();
     }
 }
 
 void ParticleSystem::update()
 {
-    // FIXME: don't hardcode 60FPS
-    float time = (wf::get_current_time() - last_update_msec) / 16.0;
-    last_update_msec = wf::get_current_time();
-
-    exec_worker_threads([=] (int start, int end)
+    // FIXME: particles move by a fixed step per update, regardless of the
+    // frame rate
+    int num_blocks = round_up(num_particles, simd::WIDTH) / simd::WIDTH;
+    wf::thread_pool_t::get().parallel_for(0, num_blocks, [=] (int start, int end)
     {
-        update_worker(time, start, end);
-    });
+        update_blocks(start, end);
+    }, PARTICLES_PER_TASK / simd::WIDTH);
 }
 
 int ParticleSystem::statistic()
@@ -180,15 +215,17 @@ int ParticleSystem::statistic()
 
 void ParticleSystem::create_program()
 {
-    /* Just load the proper context, viewport doesn't matter */
-    OpenGL::render_begin();
     program.set_simple(OpenGL::compile_program(particle_vert_source,
         particle_frag_source));
-    OpenGL::render_end();
 }
 
 void ParticleSystem::render(glm::mat4 matrix)
 {
+    if (!program.get_program_id(wf::TEXTURE_TYPE_RGBA))
+    {
+        create_program();
+    }
+
     program.use(wf::TEXTURE_TYPE_RGBA);
     static float vertex_data[] = {
         -1, -1,
@@ -203,28 +240,33 @@ void ParticleSystem::render(glm::mat4 matrix)
     program.attrib_pointer("radius", 1, 0, radius.data());
     program.attrib_divisor("radius", 1);
 
-    program.attrib_pointer("center", 2, 0, center.data());
-    program.attrib_divisor("center", 1);
+    program.attrib_pointer("center_x", 1, 0, center_x.data());
+    program.attrib_divisor("center_x", 1);
+    program.attrib_pointer("center_y", 1, 0, center_y.data());
+    program.attrib_divisor("center_y", 1);
+
+    program.attrib_pointer("color", color_per_particle, 0, color.data());
+    program.attrib_divisor("color", 1);
+    program.attrib_pointer("alpha", 1, 0, alpha.data());
+    program.attrib_divisor("alpha", 1);
 
     // matrix
     program.uniformMatrix4f("matrix", matrix);
 
     /* Darken the background */
-    program.attrib_pointer("color", 4, 0, dark_color.data());
-    program.attrib_divisor("color", 1);
-
     GL_CALL(glEnable(GL_BLEND));
     GL_CALL(glBlendFunc(GL_ZERO, GL_ONE_MINUS_SRC_ALPHA));
     program.uniform1f("smoothing", 0.7);
+    program.uniform1f("color_scale", 0.5);
 
     // TODO: optimize shaders for this case
-    GL_CALL(glDrawArraysInstanced(GL_TRIANGLE_FAN, 0, 4, ps.size()));
+    GL_CALL(glDrawArraysInstanced(GL_TRIANGLE_FAN, 0, 4, num_particles));
 
     // particle color
-    program.attrib_pointer("color", 4, 0, color.data());
     GL_CALL(glBlendFunc(GL_SRC_ALPHA, GL_ONE));
     program.uniform1f("smoothing", 0.5);
-    GL_CALL(glDrawArraysInstanced(GL_TRIANGLE_FAN, 0, 4, ps.size()));
+    program.uniform1f("color_scale", 1.0);
+    GL_CALL(glDrawArraysInstanced(GL_TRIANGLE_FAN, 0, 4, num_particles));
 
     GL_CALL(glDisable(GL_BLEND));
     GL_CALL(glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA));
@@ -4,8 +4,10 @@
 #include <wayfire/opengl.hpp>
 #include <functional>
 #include <atomic>
+#include <mutex>
 #include <vector>
 
+/* The initial state of a particle, filled in by the ParticleIniter */
 struct Particle
 {
     float life = -1;
@@ -17,11 +19,6 @@ struct Particle
     glm::vec2 start_pos;
 
     glm::vec4 color{1.0, 1.0, 1.0, 1.0};
-
-    /* update the given particle
-     * time is the percentage of the frame which has elapsed
-     * must be thread-safe */
-    void update(float time);
 };
 
 /* a function to initialize a particle */
@@ -30,8 +27,8 @@ using ParticleIniter = std::function<void (Particle&)>;
 class ParticleSystem
 {
   public:
-    /* the user of this class has to set up a proper GL context
-     * before creating the ParticleSystem */
+    /* The GL program is created on the first call to render(), so the
+     * particle system can be created and updated without a GL context */
     ParticleSystem(int num_part);
     ~ParticleSystem();
     void set_initer(ParticleIniter init);
@@ -59,31 +56,44 @@ class ParticleSystem
     int statistic();
 
     /* render particles, each will be multiplied by matrix
-     * The user of this class has to set up the same GL context that was
-     * used during the creation of the particle system */
+     * The user of this class has to set up the same GL context for all
+     * calls to render() */
     void render(glm::mat4 matrix);
 
   private:
     ParticleSystem() = delete;
 
     ParticleIniter pinit_func = [] (auto) {};
-    uint32_t last_update_msec;
-
-    std::atomic<int> particles_alive;
-    std::vector<Particle> ps;
 
-    static constexpr int color_per_particle = 4;
-    std::vector<float> color, dark_color;
+    /* Minimal number of particles updated by a single task */
+    static constexpr int PARTICLES_PER_TASK = 1024;
 
-    static constexpr int radius_per_particle = 1;
-    std::vector<float> radius;
+    int num_particles = 0;
+    std::atomic<int> particles_alive;
 
-    static constexpr int center_per_particle = 2;
-    std::vector<float> center;
+    /* Indices of dead particles, which can be spawned again */
+    std::vector<int> free_slots;
+    std::mutex free_slots_mutex;
+
+    /*
+     * The particles are stored as a structure of arrays, so that they can be
+     * updated with SIMD instructions. The arrays are padded to a multiple of
+     * the SIMD width with dead particles.
+     *
+     * center_x, center_y, radius, color and alpha are also the per-instance
+     * vertex attributes used for rendering.
+     */
+    std::vector<float> life, fade, base_radius, radius;
+    std::vector<float> center_x, center_y, start_x;
+    std::vector<float> speed_x, speed_y, g_x, g_y;
+    std::vector<float> color, alpha;
+
+    static constexpr int color_per_particle = 3;
 
     OpenGL::program_t program;
-    void exec_worker_threads(std::function<void(int, int)> spawn_worker);
-    void update_worker(float time, int start, int end);
+    void store_particle(int idx, const Particle& particle);
+    void kill_particle(int idx);
+    void update_blocks(int start, int end);
     void create_program();
 };
 
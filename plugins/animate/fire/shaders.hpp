@@ -7,10 +7,13 @@ static const char *particle_vert_source =
 
 attribute mediump float radius;
 attribute mediump vec2 position;
-attribute mediump vec2 center;
-attribute mediump vec4 color;
+attribute mediump float center_x;
+attribute mediump float center_y;
+attribute mediump vec3 color;
+attribute mediump float alpha;
 
 uniform mat4 matrix;
+uniform mediump float color_scale;
 
 varying mediump vec2 uv;
 varying mediump vec4 out_color;
@@ -18,10 +21,10 @@ varying mediump float R;
 
 void main() {
     uv = position * radius;
-    gl_Position = matrix * vec4(center.x + uv.x * 0.75, center.y + uv.y, 0.0, 1.0);
+    gl_Position = matrix * vec4(center_x + uv.x * 0.75, center_y + uv.y, 0.0, 1.0);
 
     R = radius;
-    out_color = color;
+    out_color = vec4(color, alpha) * color_scale;
 }
 )";
 
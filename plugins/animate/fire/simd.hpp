@@ -0,0 +1,71 @@
+#ifndef ANIMATION_FIRE_SIMD_HPP
+#define ANIMATION_FIRE_SIMD_HPP
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+/**
+ * A minimal portable SIMD layer based on the vector extensions of GCC and
+ * Clang. The compiler lowers the operations to SSE or AVX on x86, NEON on ARM,
+ * and to scalar code on architectures without vector instructions.
+ *
+ * Arithmetic and comparison operators work directly on the vector types.
+ * Comparisons return a mask vector, in which each lane is either all ones
+ * (true) or zero (false).
+ */
+namespace simd
+{
+constexpr int WIDTH = 4;
+
+typedef float f32x4 __attribute__((vector_size(16)));
+typedef int32_t mask32x4 __attribute__((vector_size(16)));
+
+/** Load WIDTH floats from @ptr, which does not need to be aligned. */
+inline f32x4 load(const float *ptr)
+{
+    f32x4 v;
+    std::memcpy(&v, ptr, sizeof(v));
+    return v;
+}
+
+/** Store WIDTH floats to @ptr, which does not need to be aligned. */
+inline void store(float *ptr, f32x4 v)
+{
+    std::memcpy(ptr, &v, sizeof(v));
+}
+
+inline f32x4 splat(float x)
+{
+    return f32x4{x, x, x, x};
+}
+
+/** For each lane, pick @a where @mask is set, and @b otherwise. */
+inline f32x4 select(mask32x4 mask, f32x4 a, f32x4 b)
+{
+    return (f32x4)((mask & (mask32x4)a) | (~mask & (mask32x4)b));
+}
+
+inline bool any(mask32x4 mask)
+{
+    return (mask[0] | mask[1] | mask[2] | mask[3]) != 0;
+}
+
+inline f32x4 max(f32x4 a, f32x4 b)
+{
+    return select(a > b, a, b);
+}
+
+inline f32x4 sqrt(f32x4 v)
+{
+    // There is no generic vector square root, but compilers vectorize this
+    for (int i = 0; i < WIDTH; i++)
+    {
+        v[i] = std::sqrt(v[i]);
+    }
+
+    return v;
+}
+}
+
+#endif /* end of include guard: ANIMATION_FIRE_SIMD_HPP */
@@ -26,8 +26,8 @@ class wf_system_fade
         render_hook = [=] ()
         { render(); };
 
-        output->render->add_effect(&damage_hook, wf::OUTPUT_EFFECT_PRE);
-        output->render->add_effect(&render_hook, wf::OUTPUT_EFFECT_OVERLAY);
+        output->render->add_effect(&damage_hook, wf::OUTPUT_EFFECT_PRE, "animate");
+        output->render->add_effect(&render_hook, wf::OUTPUT_EFFECT_OVERLAY, "animate");
         output->render->set_redraw_always();
         this->progression.animate(1, 0);
     }
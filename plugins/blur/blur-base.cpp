@@ -58,12 +58,23 @@ wf_blur_base::wf_blur_base(wf::output_t *output, std::string name)
     this->degrade_opt.load_option("blur/" + algorithm_name + "_degrade");
     this->iterations_opt.load_option("blur/" + algorithm_name + "_iterations");
 
-    this->options_changed = [=] () { output->render->damage_whole(); };
+    this->options_changed = [=] ()
+    {
+        for (auto& [layer, cache] : layer_caches)
+        {
+            cache->damage |= cache->target.geometry;
+        }
+
+        output->render->damage_whole();
+    };
     this->saturation_opt.set_callback(options_changed);
     this->offset_opt.set_callback(options_changed);
     this->degrade_opt.set_callback(options_changed);
     this->iterations_opt.set_callback(options_changed);
 
+    fb[0].owner = fb[1].owner = "blur";
+    idle_drop_caches.set_callback([=] () { drop_unused_caches(); });
+
     OpenGL::render_begin();
     blend_program.compile(blur_blend_vertex_shader, blur_blend_fragment_shader);
     OpenGL::render_end();
@@ -71,6 +82,8 @@ wf_blur_base::wf_blur_base(wf::output_t *output, std::string name)
 
 wf_blur_base::~wf_blur_base()
 {
+    layer_caches.clear();
+
     OpenGL::render_begin();
     fb[0].release();
     fb[1].release();
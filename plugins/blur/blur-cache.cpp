@@ -0,0 +1,329 @@
+#include "blur.hpp"
+#include <wayfire/output.hpp>
+#include <wayfire/util/log.hpp>
+#include <cmath>
+
+/* How often the cache statistics are logged */
+static constexpr auto CACHE_STATS_INTERVAL = std::chrono::seconds(10);
+
+blur_layer_cache_t::~blur_layer_cache_t()
+{
+    OpenGL::render_begin();
+    source.release();
+    blurred.release();
+    OpenGL::render_end();
+}
+
+std::optional<wf::scene::layer> find_node_layer(wf::scene::node_t *node)
+{
+    auto root = wf::get_core().scene();
+    while (node && (node->parent() != root.get()))
+    {
+        node = node->parent();
+    }
+
+    for (size_t i = 0; i < (size_t)wf::scene::layer::ALL_LAYERS; i++)
+    {
+        if (node && (root->layers[i].get() == node))
+        {
+            return (wf::scene::layer)i;
+        }
+    }
+
+    return {};
+}
+
+blur_layer_cache_t& wf_blur_base::get_layer_cache(wf::scene::layer layer)
+{
+    auto& cache = layer_caches[layer];
+    if (cache)
+    {
+        return *cache;
+    }
+
+    cache = std::make_unique<blur_layer_cache_t>();
+    auto cache_ptr = cache.get();
+    auto regenerate = [=] ()
+    {
+        wf::scene::damage_callback push_damage = [=] (const wf::region_t& region)
+        {
+            cache_ptr->damage |= region;
+        };
+
+        auto root = wf::get_core().scene();
+        cache_ptr->instances.clear();
+        for (size_t i = 0; i < (size_t)layer; i++)
+        {
+            root->layers[i]->gen_render_instances(cache_ptr->instances,
+                push_damage, output);
+        }
+
+        cache_ptr->damage |= cache_ptr->target.geometry;
+    };
+
+    cache->on_root_update = [=] (wf::scene::root_node_update_signal *ev)
+    {
+        if (!(ev->flags & wf::scene::update_flag::CHILDREN_LIST) &&
+            !(ev->flags & wf::scene::update_flag::ENABLED))
+        {
+            return;
+        }
+
+        // Removed nodes have no layer anymore
+        auto changed_layer = find_node_layer(ev->changed_node);
+        if (!changed_layer || (*changed_layer == layer))
+        {
+            idle_drop_caches.run_once();
+        }
+
+        // Changes in the layer itself or above do not affect the background
+        if (changed_layer && (*changed_layer >= layer))
+        {
+            return;
+        }
+
+        regenerate();
+    };
+
+    wf::get_core().scene()->connect(&cache->on_root_update);
+    regenerate();
+
+    return *cache;
+}
+
+static bool contains_blur_node(wf::scene::node_t *node)
+{
+    if (!node->is_enabled())
+    {
+        return false;
+    }
+
+    if (is_blur_node(node))
+    {
+        return true;
+    }
+
+    for (auto& child : node->get_children())
+    {
+        if (contains_blur_node(child.get()))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void wf_blur_base::drop_unused_caches()
+{
+    auto root = wf::get_core().scene();
+    for (auto it = layer_caches.begin(); it != layer_caches.end();)
+    {
+        if (contains_blur_node(root->layers[(size_t)it->first].get()))
+        {
+            ++it;
+        } else
+        {
+            LOGD("Dropping blur cache of layer ", (int)it->first, " on ",
+                output->to_string());
+            it = layer_caches.erase(it);
+        }
+    }
+}
+
+/**
+ * Scale a region by different factors in x and y direction, rounding
+ * outwards.
+ */
+static wf::region_t scale_region(const wf::region_t& region, double sx, double sy)
+{
+    wf::region_t result;
+    for (const auto& rect : region)
+    {
+        int x1 = std::floor(rect.x1 * sx);
+        int y1 = std::floor(rect.y1 * sy);
+        int x2 = std::ceil(rect.x2 * sx);
+        int y2 = std::ceil(rect.y2 * sy);
+        result |= wlr_box{x1, y1, x2 - x1, y2 - y1};
+    }
+
+    return result;
+}
+
+void wf_blur_base::update_layer_cache(blur_layer_cache_t& cache)
+{
+    auto& target = cache.target;
+    auto full_box = target.framebuffer_box_from_geometry_box(target.geometry);
+    int degrade   = degrade_opt;
+    int degraded_width  = std::max(1, (full_box.width + degrade - 1) / degrade);
+    int degraded_height = std::max(1, (full_box.height + degrade - 1) / degrade);
+
+    OpenGL::render_begin();
+    cache.source.owner  = "blur";
+    cache.blurred.owner = "blur";
+    bool invalidated = cache.source.allocate(full_box.width, full_box.height);
+    invalidated |= cache.blurred.allocate(degraded_width, degraded_height);
+    OpenGL::render_end();
+
+    if (invalidated)
+    {
+        cache.damage |= target.geometry;
+    }
+
+    wf::region_t damage = cache.damage & target.geometry;
+    cache.damage.clear();
+    if (damage.empty())
+    {
+        return;
+    }
+
+    /* Render the damaged parts of the layers below */
+    wf::scene::render_pass_params_t params;
+    params.instances = &cache.instances;
+    params.target    = target;
+    params.target.fb = cache.source.fb;
+    params.target.tex = cache.source.tex;
+    params.damage     = damage;
+    params.background_color = background_color_opt;
+    // Emit the render pass signals, so that the damage is expanded for
+    // blurred nodes in the layers below, like in the main render pass.
+    wf::scene::run_render_pass(params,
+        wf::scene::RPASS_CLEAR_BACKGROUND | wf::scene::RPASS_EMIT_SIGNALS);
+
+    /* A changed pixel changes the blurred pixels around it. To get these
+     * right, the blur itself has to be computed on an even larger area. */
+    const int radius = calculate_blur_radius();
+    wf::region_t fb_damage;
+    for (const auto& rect : damage)
+    {
+        fb_damage |= target.framebuffer_box_from_geometry_box(
+            wlr_box_from_pixman_box(rect));
+    }
+
+    const double sx = 1.0 * degraded_width / full_box.width;
+    const double sy = 1.0 * degraded_height / full_box.height;
+    const wlr_box degraded_box = {0, 0, degraded_width, degraded_height};
+
+    wf::region_t changed_region = fb_damage;
+    changed_region.expand_edges(radius);
+    changed_region = scale_region(changed_region, sx, sy) & degraded_box;
+
+    wf::region_t blur_region = fb_damage;
+    blur_region.expand_edges(2 * radius);
+    blur_region = scale_region(blur_region, sx, sy) & degraded_box;
+
+    OpenGL::render_begin();
+    fb[0].allocate(degraded_width, degraded_height);
+    GL_CALL(glBindFramebuffer(GL_READ_FRAMEBUFFER, cache.source.fb));
+    GL_CALL(glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fb[0].fb));
+    GL_CALL(glBlitFramebuffer(0, 0, full_box.width, full_box.height,
+        0, 0, degraded_width, degraded_height,
+        GL_COLOR_BUFFER_BIT, GL_LINEAR));
+    OpenGL::render_end();
+
+    int r = blur_fb0(blur_region, degraded_width, degraded_height);
+
+    /* Store the changed part of the result */
+    OpenGL::render_begin();
+    GL_CALL(glBindFramebuffer(GL_READ_FRAMEBUFFER, fb[r].fb));
+    GL_CALL(glBindFramebuffer(GL_DRAW_FRAMEBUFFER, cache.blurred.fb));
+    for (const auto& box : changed_region)
+    {
+        GL_CALL(glBlitFramebuffer(
+            box.x1, degraded_height - box.y2, box.x2, degraded_height - box.y1,
+            box.x1, degraded_height - box.y2, box.x2, degraded_height - box.y1,
+            GL_COLOR_BUFFER_BIT, GL_NEAREST));
+    }
+
+    OpenGL::render_end();
+}
+
+bool wf_blur_base::pre_render_cached(std::optional<wf::scene::layer> layer,
+    wlr_box src_box, const wf::render_target_t& target_fb, wf::point_t offset)
+{
+    // Only the normal output contents are cached, not for example workspace
+    // streams or the auxiliary buffers of other transformers.
+    auto root_geometry = target_fb.geometry + offset;
+    if (!layer || target_fb.has_nonstandard_transform ||
+        (root_geometry != output->get_layout_geometry()))
+    {
+        ++cache_stats.uncached;
+        log_cache_stats();
+        return false;
+    }
+
+    auto& cache = get_layer_cache(*layer);
+    if ((cache.target.geometry != root_geometry) ||
+        (cache.target.scale != target_fb.scale) ||
+        (cache.target.wl_transform != target_fb.wl_transform) ||
+        (cache.target.viewport_width != target_fb.viewport_width) ||
+        (cache.target.viewport_height != target_fb.viewport_height))
+    {
+        cache.target = target_fb;
+        cache.target.geometry = root_geometry;
+        cache.damage |= root_geometry;
+    }
+
+    // The blurred background of src_box depends on the area around it
+    wf::region_t needed{src_box + offset};
+    needed.expand_edges(std::ceil(calculate_blur_radius() / target_fb.scale));
+    if ((cache.damage & needed).empty())
+    {
+        ++cache_stats.hits;
+    } else
+    {
+        ++cache_stats.updates;
+        update_layer_cache(cache);
+    }
+
+    log_cache_stats();
+
+    /* Scale the view box from the blurred background into fb[1], like
+     * pre_render() does. The boxes are converted to GL coordinates, where y
+     * grows upwards. */
+    auto full_box = cache.target.framebuffer_box_from_geometry_box(root_geometry);
+    auto view_box = target_fb.framebuffer_box_from_geometry_box(src_box);
+    const double sx = 1.0 * cache.blurred.viewport_width / full_box.width;
+    const double sy = 1.0 * cache.blurred.viewport_height / full_box.height;
+
+    int gl_y = full_box.height - view_box.y - view_box.height;
+    int x1   = std::floor(view_box.x * sx);
+    int y1   = std::floor(gl_y * sy);
+    int x2   = std::ceil((view_box.x + view_box.width) * sx);
+    int y2   = std::ceil((gl_y + view_box.height) * sy);
+
+    OpenGL::render_begin();
+    fb[1].allocate(view_box.width, view_box.height);
+    fb[1].bind();
+    GL_CALL(glBindFramebuffer(GL_READ_FRAMEBUFFER, cache.blurred.fb));
+    GL_CALL(glBlitFramebuffer(x1, y1, x2, y2,
+        std::lround(x1 / sx) - view_box.x, std::lround(y1 / sy) - gl_y,
+        std::lround(x2 / sx) - view_box.x, std::lround(y2 / sy) - gl_y,
+        GL_COLOR_BUFFER_BIT, GL_LINEAR));
+    OpenGL::render_end();
+
+    return true;
+}
+
+void wf_blur_base::log_cache_stats()
+{
+    auto now = std::chrono::steady_clock::now();
+    if (cache_stats.last_log == std::chrono::steady_clock::time_point{})
+    {
+        cache_stats.last_log = now;
+    }
+
+    if (now - cache_stats.last_log < CACHE_STATS_INTERVAL)
+    {
+        return;
+    }
+
+    int total = cache_stats.hits + cache_stats.updates + cache_stats.uncached;
+    LOGD("Blur cache on ", output->to_string(), ": ",
+        100 * cache_stats.hits / std::max(total, 1), "% hit rate (",
+        cache_stats.hits, " hits, ", cache_stats.updates, " updates, ",
+        cache_stats.uncached, " uncached)");
+
+    cache_stats = {};
+    cache_stats.last_log = now;
+}
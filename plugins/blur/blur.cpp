@@ -155,6 +155,7 @@ class blur_render_instance_t : public transformer_render_instance_t<blur_node_t>
         }
 
         OpenGL::render_begin();
+        saved_pixels.owner = "blur";
         saved_pixels.allocate(target.viewport_width, target.viewport_height);
         saved_pixels.bind();
         GL_CALL(glBindFramebuffer(GL_READ_FRAMEBUFFER, target.fb));
@@ -181,6 +182,50 @@ class blur_render_instance_t : public transformer_render_instance_t<blur_node_t>
                 });
     }
 
+    /**
+     * The background of the node consists only of the layers below its layer
+     * if no other node in its layer is below it, within @box. In this case,
+     * return the layer, and store the position of the node's coordinate system
+     * in the scenegraph root in @offset.
+     */
+    std::optional<wf::scene::layer> find_background_layer(wf::geometry_t box,
+        wf::point_t& offset)
+    {
+        const wf::point_t start = wf::origin(box);
+        node_t *node = self;
+        while (node->parent() && (node->parent() != wf::get_core().scene().get()))
+        {
+            auto parent = node->parent();
+            bool below  = false;
+            for (auto& sibling : parent->get_children())
+            {
+                if (below && sibling->is_enabled() &&
+                    !(wf::region_t{sibling->get_bounding_box()} & box).empty())
+                {
+                    return {};
+                }
+
+                below |= (sibling.get() == node);
+            }
+
+            // Only translations can be mapped onto the cache
+            auto p1 = parent->to_global({1.0 * box.x, 1.0 * box.y});
+            auto p2 = parent->to_global(
+                {1.0 * box.x + box.width, 1.0 * box.y + box.height});
+            if ((p2.x - p1.x != box.width) || (p2.y - p1.y != box.height))
+            {
+                return {};
+            }
+
+            box.x = p1.x;
+            box.y = p1.y;
+            node  = parent;
+        }
+
+        offset = wf::origin(box) - start;
+        return find_node_layer(node);
+    }
+
     void render(const wf::render_target_t& target,
         const wf::region_t& damage) override
     {
@@ -190,11 +235,29 @@ class blur_render_instance_t : public transformer_render_instance_t<blur_node_t>
         {
             auto translucent_damage = calculate_translucent_damage(target.scale,
                 damage);
-            self->provider()->pre_render(bounding_box, translucent_damage, target);
+            auto provider = self->provider();
+            if (!translucent_damage.empty())
+            {
+                const int padding = std::ceil(
+                    provider->calculate_blur_radius() / target.scale);
+                wf::geometry_t padded_box = bounding_box;
+                padded_box.x     -= padding;
+                padded_box.y     -= padding;
+                padded_box.width += 2 * padding;
+                padded_box.height += 2 * padding;
+
+                wf::point_t offset = {0, 0};
+                auto layer = find_background_layer(padded_box, offset);
+                if (!provider->pre_render_cached(layer, bounding_box, target, offset))
+                {
+                    provider->pre_render(bounding_box, translucent_damage, target);
+                }
+            }
+
             for (const auto& rect : damage)
             {
                 auto damage_box = wlr_box_from_pixman_box(rect);
-                self->provider()->render(tex, bounding_box, damage_box, target);
+                provider->render(tex, bounding_box, damage_box, target);
             }
         }
 
@@ -240,6 +303,11 @@ void blur_node_t::gen_render_instances(std::vector<render_instance_uptr>& instan
 }
 }
 
+bool is_blur_node(wf::scene::node_t *node)
+{
+    return dynamic_cast<wf::scene::blur_node_t*>(node) != nullptr;
+}
+
 class blur_global_data_t
 {
     // Before doing a render pass, expand the damage by the blur radius.
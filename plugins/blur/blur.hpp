@@ -1,7 +1,15 @@
 #include <wayfire/core.hpp>
+#include <wayfire/config/types.hpp>
 #include <wayfire/opengl.hpp>
 #include <wayfire/render-manager.hpp>
 #include <wayfire/region.hpp>
+#include <wayfire/scene.hpp>
+#include <wayfire/scene-render.hpp>
+#include <wayfire/util.hpp>
+
+#include <chrono>
+#include <map>
+#include <optional>
 
 /* The MIT License (MIT)
  *
@@ -86,6 +94,33 @@
  * `````````````````````````````````````````````````````````````````
  */
 
+/**
+ * The blurred background of a layer on an output, that is, the blurred image
+ * of all layers below it.
+ *
+ * The cache has its own render instances for the layers below, so it knows
+ * exactly when they are damaged, and only the damaged parts are rendered and
+ * blurred again. Damage to the layer itself or the layers above, like a
+ * blinking cursor in a blurred terminal, does not invalidate the cache.
+ */
+struct blur_layer_cache_t
+{
+    std::vector<wf::scene::render_instance_uptr> instances;
+    wf::signal::connection_t<wf::scene::root_node_update_signal> on_root_update;
+
+    /* Damage of the layers below since the last update, in root coordinates */
+    wf::region_t damage;
+    /* The target for which the cache was rendered, in root coordinates */
+    wf::render_target_t target;
+
+    /* The layers below, at full resolution */
+    wf::framebuffer_t source;
+    /* The blurred layers below, at the degraded resolution */
+    wf::framebuffer_t blurred;
+
+    ~blur_layer_cache_t();
+};
+
 class wf_blur_base
 {
   protected:
@@ -109,6 +144,27 @@ class wf_blur_base
 
     wf::output_t *output;
 
+    wf::option_wrapper_t<wf::color_t> background_color_opt{"core/background_color"};
+
+    /* blurred backgrounds, one for each layer which contains blurred nodes */
+    std::map<wf::scene::layer, std::unique_ptr<blur_layer_cache_t>> layer_caches;
+
+    /* number of pre_render_cached() calls which found a valid cache, which
+     * had to update the cache, and which could not use it, for the logs */
+    struct
+    {
+        int hits = 0, updates = 0, uncached = 0;
+        std::chrono::steady_clock::time_point last_log;
+    } cache_stats;
+
+    blur_layer_cache_t& get_layer_cache(wf::scene::layer layer);
+    /* free the caches of layers which contain no blurred nodes anymore */
+    void drop_unused_caches();
+    wf::wl_idle_call idle_drop_caches;
+    /* render and blur the damaged parts of the cache */
+    void update_layer_cache(blur_layer_cache_t& cache);
+    void log_cache_stats();
+
     /* renders the in texture to the out framebuffer.
      * assumes a properly bound and initialized GL program */
     void render_iteration(wf::region_t blur_region,
@@ -134,10 +190,34 @@ class wf_blur_base
     virtual void pre_render(wlr_box src_box,
         const wf::region_t& damage, const wf::render_target_t& target_fb);
 
+    /**
+     * Like pre_render(), but take the blurred background of the whole @src_box
+     * from the cache of @layer, which contains only the layers below it. This
+     * may be used only by nodes which have no other nodes of their layer below
+     * them.
+     *
+     * @param offset The position of the coordinate system of @target_fb in the
+     *   scenegraph root.
+     * @return false if there is no layer, or if the cache does not cover
+     *   @target_fb. In this case, pre_render() has to be used.
+     */
+    bool pre_render_cached(std::optional<wf::scene::layer> layer, wlr_box src_box,
+        const wf::render_target_t& target_fb, wf::point_t offset);
+
     virtual void render(wf::texture_t src_tex, wlr_box src_box,
         wlr_box scissor_box, const wf::render_target_t& target_fb);
 };
 
+/**
+ * Find the layer which contains @node.
+ */
+std::optional<wf::scene::layer> find_node_layer(wf::scene::node_t *node);
+
+/**
+ * Check whether @node is a node which blurs its background.
+ */
+bool is_blur_node(wf::scene::node_t *node);
+
 std::unique_ptr<wf_blur_base> create_box_blur(wf::output_t *output);
 std::unique_ptr<wf_blur_base> create_bokeh_blur(wf::output_t *output);
 std::unique_ptr<wf_blur_base> create_kawase_blur(wf::output_t *output);
@@ -292,8 +292,8 @@ class output_data_t : public custom_data_t
   public:
     output_data_t(wf::output_t *output, std::vector<dragged_view_t> views)
     {
-        output->render->add_effect(&damage_overlay, OUTPUT_EFFECT_PRE);
-        output->render->add_effect(&render_overlay, OUTPUT_EFFECT_OVERLAY);
+        output->render->add_effect(&damage_overlay, OUTPUT_EFFECT_PRE, "move-drag");
+        output->render->add_effect(&render_overlay, OUTPUT_EFFECT_OVERLAY, "move-drag");
 
         this->output = output;
         this->views  = views;
@@ -66,7 +66,8 @@ class preview_indication_view_t : public wf::color_rect_view_t
         if (output)
         {
             pre_paint = [=] () { update_animation(); };
-            output->render->add_effect(&pre_paint, wf::OUTPUT_EFFECT_PRE);
+            output->render->add_effect(&pre_paint, wf::OUTPUT_EFFECT_PRE,
+                "preview-indication");
             output->workspace->add_view(self(), wf::LAYER_TOP);
         }
     }
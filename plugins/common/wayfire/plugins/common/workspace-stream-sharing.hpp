@@ -73,8 +73,13 @@ class workspace_stream_pool_t : public wf::custom_data_t
      * Update the contents of the given workspace.
      *
      * If the workspace has not been started before, it will be started.
+     *
+     * @param scale The size at which the workspace will be displayed, relative
+     *   to the size of the output. The workspace is rendered at a reduced
+     *   resolution if it is displayed scaled down, see
+     *   workspace_stream_t::set_scale().
      */
-    void update(wf::point_t workspace)
+    void update(wf::point_t workspace, float scale = 1.0)
     {
         auto& stream = get(workspace);
         if (!stream.current_output)
@@ -82,9 +87,38 @@ class workspace_stream_pool_t : public wf::custom_data_t
             stream.start_for_workspace(output, stream.ws);
         }
 
+        stream.set_scale(scale);
         stream.render_frame();
     }
 
+    /**
+     * Update the contents of several workspaces at once.
+     *
+     * The workspaces are rendered with a single set of render instances shared
+     * by all of them, which is cheaper than calling update() for each of them
+     * when many workspaces are visible at the same time.
+     *
+     * @param scale The size at which the workspaces will be displayed, see
+     *   update().
+     */
+    void update_all(const std::vector<wf::point_t>& workspaces, float scale = 1.0)
+    {
+        if (!renderer)
+        {
+            renderer = std::make_unique<workspace_stream_renderer_t>(output);
+        }
+
+        std::vector<workspace_stream_t*> to_render;
+        for (auto& ws : workspaces)
+        {
+            auto& stream = get(ws);
+            stream.set_scale(scale);
+            to_render.push_back(&stream);
+        }
+
+        renderer->render(to_render);
+    }
+
     /**
      * Stop the workspace stream.
      */
@@ -94,6 +128,16 @@ class workspace_stream_pool_t : public wf::custom_data_t
         stream.stop();
     }
 
+    /**
+     * Destroy the shared render instances used by update_all(), so that they
+     * are not kept up to date while no workspaces are being updated. The next
+     * call to update_all() renders the workspaces from scratch.
+     */
+    void stop_all()
+    {
+        renderer.reset();
+    }
+
   private:
     workspace_stream_pool_t(wf::output_t *output)
     {
@@ -104,6 +148,7 @@ class workspace_stream_pool_t : public wf::custom_data_t
 
     void resize_pool(wf::dimensions_t size)
     {
+        this->renderer.reset();
         for (auto& column : this->streams)
         {
             for (auto& stream : column)
@@ -134,6 +179,8 @@ class workspace_stream_pool_t : public wf::custom_data_t
 
     wf::output_t *output;
     std::vector<std::vector<std::unique_ptr<wf::workspace_stream_t>>> streams;
+    /* Created on the first call to update_all() */
+    std::unique_ptr<workspace_stream_renderer_t> renderer;
 
     wf::signal_connection_t on_workspace_grid_changed = [=] (auto)
     {
@@ -105,7 +105,11 @@ class workspace_wall_t : public wf::signal_provider_t
      */
     void render_wall(const wf::render_target_t& fb, wf::geometry_t geometry)
     {
-        update_streams();
+        // Workspaces are displayed at the size of the viewport scaled to the
+        // target geometry, and do not need more resolution than that.
+        update_streams(std::max(
+            geometry.width * 1.0 / std::max(1, viewport.width),
+            geometry.height * 1.0 / std::max(1, viewport.height)));
 
         OpenGL::render_begin(fb);
         fb.logic_scissor(geometry);
@@ -155,6 +159,7 @@ class workspace_wall_t : public wf::signal_provider_t
         if (render_hook_set)
         {
             this->output->render->set_renderer(nullptr);
+            streams->stop_all();
             render_hook_set = false;
         }
 
@@ -218,13 +223,14 @@ class workspace_wall_t : public wf::signal_provider_t
 
     std::vector<std::vector<glm::vec4>> render_colors;
 
-    /** Update or start visible streams */
-    void update_streams()
+    /**
+     * Update visible streams.
+     *
+     * @param scale The scale at which the workspaces are displayed.
+     */
+    void update_streams(float scale)
     {
-        for (auto& ws : get_visible_workspaces(viewport))
-        {
-            streams->update(ws);
-        }
+        streams->update_all(get_visible_workspaces(viewport), scale);
     }
 
     /**
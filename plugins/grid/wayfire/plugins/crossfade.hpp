@@ -185,7 +185,7 @@ class grid_animation_t : public wf::custom_data_t
         this->type   = type;
         this->animation = wf::geometry_animation_t{duration};
 
-        output->render->add_effect(&pre_hook, wf::OUTPUT_EFFECT_PRE);
+        output->render->add_effect(&pre_hook, wf::OUTPUT_EFFECT_PRE, "crossfade");
         output->connect_signal("view-disappeared", &unmapped);
     }
 
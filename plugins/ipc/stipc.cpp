@@ -3,6 +3,8 @@
 #include <wayfire/output.hpp>
 #include <wayfire/workspace-manager.hpp>
 #include <wayfire/output-layout.hpp>
+#include <wayfire/render-manager.hpp>
+#include <wayfire/opengl.hpp>
 #include <getopt.h>
 #include <wayland-server-protocol.h>
 
@@ -61,6 +63,74 @@ static nlohmann::json geometry_to_json(wf::geometry_t g)
     return j;
 }
 
+static nlohmann::json histogram_to_json(const wf::frame_timing_histogram_t& h)
+{
+    nlohmann::json j;
+    j["count"]    = h.count;
+    j["total-ns"] = h.total_ns;
+    j["max-ns"]   = h.max_ns;
+    j["buckets-us"] = nlohmann::json::array();
+    for (int i = 0; i < wf::frame_timing_histogram_t::BUCKETS; i++)
+    {
+        j["buckets-us"].push_back({{"from", (i == 0) ? 0 : (1 << i)},
+            {"count", h.buckets[i]}});
+    }
+
+    return j;
+}
+
+static nlohmann::json frame_timing_to_json(const wf::frame_timing_stats_t& stats)
+{
+    static const char *results[] = {"rendered", "scanout", "skipped"};
+
+    nlohmann::json j;
+    j["gpu-timer"] = stats.gpu_timer_available;
+
+    j["frames"] = nlohmann::json::array();
+    for (auto& sample : stats.samples)
+    {
+        nlohmann::json frame;
+        frame["seq"]      = sample.seq;
+        frame["start-ns"] = sample.start_ns;
+        frame["result"]   = results[sample.result];
+        frame["total-ns"] = sample.total_ns;
+        frame["gpu-ns"]   = sample.gpu_ns;
+        for (int i = 0; i < wf::FRAME_PHASE_TOTAL; i++)
+        {
+            if (sample.phase_ns[i] >= 0)
+            {
+                frame["phases-ns"][wf::frame_phase_to_string((wf::frame_phase_t)i)] =
+                    sample.phase_ns[i];
+            }
+        }
+
+        j["frames"].push_back(frame);
+    }
+
+    for (int i = 0; i < wf::FRAME_PHASE_TOTAL; i++)
+    {
+        j["histograms"][wf::frame_phase_to_string((wf::frame_phase_t)i)] =
+            histogram_to_json(stats.phases[i]);
+    }
+
+    j["histograms"]["total"] = histogram_to_json(stats.total);
+    j["histograms"]["gpu"]   = histogram_to_json(stats.gpu);
+
+    j["hooks"] = nlohmann::json::array();
+    for (auto& hook : stats.hooks)
+    {
+        j["hooks"].push_back({
+            {"owner", hook.owner},
+            {"stage", hook.stage},
+            {"calls", hook.calls},
+            {"total-ns", hook.total_ns},
+            {"max-ns", hook.max_ns},
+        });
+    }
+
+    return j;
+}
+
 static std::string layer_to_string(uint32_t layer)
 {
     switch (layer)
@@ -266,6 +336,8 @@ class ipc_plugin_t
         server->register_method("core/layout_views", layout_views);
         server->register_method("core/touch", do_touch);
         server->register_method("core/touch_release", do_touch_release);
+        server->register_method("core/get_frame_timing", get_frame_timing);
+        server->register_method("core/get_framebuffer_pool", get_framebuffer_pool);
     }
 
     using method_t = ipc::server_t::method_cb;
@@ -528,6 +600,64 @@ class ipc_plugin_t
         return dpy;
     };
 
+    method_t get_frame_timing = [=] (nlohmann::json data)
+    {
+        std::vector<wf::output_t*> outputs = wf::get_core().output_layout->get_outputs();
+        if (data.contains("output"))
+        {
+            EXPECT_FIELD(data, "output", string);
+            auto wo = wf::get_core().output_layout->find_output(data["output"]);
+            if (!wo)
+            {
+                return get_error("Unknown output " + (std::string)data["output"]);
+            }
+
+            outputs = {wo};
+        }
+
+        if (data.contains("reset"))
+        {
+            EXPECT_FIELD(data, "reset", boolean);
+        }
+
+        auto response = get_ok();
+        for (auto& wo : outputs)
+        {
+            response["outputs"][wo->to_string()] =
+                frame_timing_to_json(wo->render->get_frame_timing());
+            if (data.value("reset", false))
+            {
+                wo->render->reset_frame_timing();
+            }
+        }
+
+        return response;
+    };
+
+    method_t get_framebuffer_pool = [=] (nlohmann::json)
+    {
+        auto stats    = OpenGL::get_framebuffer_pool_stats();
+        auto response = get_ok();
+        response["in-use"] = nlohmann::json::object();
+        for (auto& [owner, usage] : stats.in_use)
+        {
+            response["in-use"][owner] = {
+                {"count", usage.count},
+                {"bytes", usage.bytes},
+            };
+        }
+
+        response["idle"] = {
+            {"count", stats.idle.count},
+            {"bytes", stats.idle.bytes},
+        };
+        response["budget-bytes"] = stats.budget;
+        response["created"] = stats.created;
+        response["reused"]  = stats.reused;
+        response["evicted"] = stats.evicted;
+        return response;
+    };
+
     std::unique_ptr<ipc::server_t> server;
     std::unique_ptr<headless_input_backend_t> input;
 };
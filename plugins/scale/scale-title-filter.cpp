@@ -304,7 +304,8 @@ class scale_title_filter : public wf::singleton_plugin_t<scale_title_filter_text
 
         if (!render_active)
         {
-            output->render->add_effect(&render_hook, wf::OUTPUT_EFFECT_OVERLAY);
+            output->render->add_effect(&render_hook, wf::OUTPUT_EFFECT_OVERLAY,
+                "scale-title-filter");
             render_active = true;
         }
 
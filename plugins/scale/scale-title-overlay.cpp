@@ -259,7 +259,7 @@ class title_overlay_node_t : public node_t
         }
 
         this->output = view->get_output();
-        output->render->add_effect(&pre_render, OUTPUT_EFFECT_PRE);
+        output->render->add_effect(&pre_render, OUTPUT_EFFECT_PRE, "scale");
     }
 
     ~title_overlay_node_t()
@@ -294,9 +294,12 @@ class wayfire_command : public wf::plugin_interface_t
         using namespace std::placeholders;
 
         setup_bindings_from_config();
-        reload_config.set_callback([=] (wf::signal_data_t*)
+        reload_config.set_callback([=] (wf::signal_data_t *data)
         {
-            setup_bindings_from_config();
+            if (wf::config_section_changed(data, "command"))
+            {
+                setup_bindings_from_config();
+            }
         });
 
         wf::get_core().connect_signal("reload-config", &reload_config);
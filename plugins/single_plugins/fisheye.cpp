@@ -152,7 +152,7 @@ class wayfire_fisheye : public wf::plugin_interface_t
             if (!hook_set)
             {
                 hook_set = true;
-                output->render->add_post(&render_hook);
+                output->render->add_post(&render_hook, "fisheye");
                 output->render->set_redraw_always();
             }
         }
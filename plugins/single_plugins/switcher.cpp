@@ -238,7 +238,7 @@ class WayfireSwitcher : public wf::plugin_interface_t
             return false;
         }
 
-        output->render->add_effect(&damage, wf::OUTPUT_EFFECT_PRE);
+        output->render->add_effect(&damage, wf::OUTPUT_EFFECT_PRE, "switcher");
         output->render->set_renderer(switcher_renderer);
         output->render->set_redraw_always();
 
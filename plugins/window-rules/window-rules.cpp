@@ -60,9 +60,12 @@ class wayfire_window_rules_t : public wf::plugin_interface_t
     };
 
     // Auto-reload on changes to config file
-    wf::signal_connection_t _reload_config = [=] (wf::signal_data_t*)
+    wf::signal_connection_t _reload_config = [=] (wf::signal_data_t *data)
     {
-        setup_rules_from_config();
+        if (wf::config_section_changed(data, "window-rules"))
+        {
+            setup_rules_from_config();
+        }
     };
 
     std::vector<std::shared_ptr<wf::rule_t>> _rules;
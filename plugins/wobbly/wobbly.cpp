@@ -565,7 +565,8 @@ class wobbly_transformer_node_t : public wf::scene::floating_inner_node_t
         last_frame = wf::get_current_time();
 
         pre_hook = [=] () { update_model(); };
-        view->get_output()->render->add_effect(&pre_hook, wf::OUTPUT_EFFECT_PRE);
+        view->get_output()->render->add_effect(&pre_hook,
+            wf::OUTPUT_EFFECT_PRE, "wobbly");
         view->get_output()->connect_signal("workspace-changed",
             &on_workspace_changed);
 
@@ -668,7 +669,7 @@ class wobbly_transformer_node_t : public wf::scene::floating_inner_node_t
 
         sig->output->render->rem_effect(&pre_hook);
         view->get_output()->render->add_effect(&pre_hook,
-            wf::OUTPUT_EFFECT_PRE);
+            wf::OUTPUT_EFFECT_PRE, "wobbly");
 
         on_workspace_changed.disconnect();
         view->get_output()->connect_signal("workspace-changed",
@@ -68,6 +68,8 @@ enum class logging_category : size_t
     WLR     = 3,
     // Direct scanout
     SCANOUT = 4,
+    // Render tree and render pass statistics
+    RENDER  = 5,
     TOTAL,
 };
 
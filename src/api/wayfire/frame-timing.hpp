@@ -0,0 +1,123 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace wf
+{
+/**
+ * The phases of the repaint cycle of an output, in the order in which they
+ * are executed.
+ */
+enum frame_phase_t
+{
+    /* PRE and DAMAGE effect hooks */
+    FRAME_PHASE_EFFECTS      = 0,
+    /* Attempt to directly scan out a view */
+    FRAME_PHASE_SCANOUT      = 1,
+    /* Attach the renderer to the output */
+    FRAME_PHASE_MAKE_CURRENT = 2,
+    /* Render the scenegraph or run the custom renderer */
+    FRAME_PHASE_RENDER       = 3,
+    /* OVERLAY effect hooks */
+    FRAME_PHASE_OVERLAY      = 4,
+    /* Postprocessing hooks */
+    FRAME_PHASE_POSTPROCESS  = 5,
+    /* Software cursors */
+    FRAME_PHASE_CURSORS      = 6,
+    /* Committing the buffer to the output */
+    FRAME_PHASE_SWAP         = 7,
+    /* POST effect hooks */
+    FRAME_PHASE_POST_EFFECTS = 8,
+    FRAME_PHASE_TOTAL        = 9,
+};
+
+/** @return A short name of the given phase, for example "render". */
+const char *frame_phase_to_string(frame_phase_t phase);
+
+/** How a repaint cycle ended. */
+enum frame_result_t
+{
+    /* The output was repainted and the buffers were swapped. */
+    FRAME_RESULT_RENDERED = 0,
+    /* A view was scanned out directly, nothing was rendered. */
+    FRAME_RESULT_SCANOUT  = 1,
+    /* The output was not damaged or could not be attached. */
+    FRAME_RESULT_SKIPPED  = 2,
+};
+
+/** The timings of a single repaint cycle. All durations are in nanoseconds. */
+struct frame_timing_sample_t
+{
+    /* A sequence number of the frame, increasing by one for each frame. */
+    uint64_t seq = 0;
+    /* The start of the frame, as measured by the steady clock. */
+    int64_t start_ns = 0;
+    frame_result_t result = FRAME_RESULT_SKIPPED;
+    /* The CPU time spent in each phase, or -1 if the phase did not run. */
+    std::array<int64_t, FRAME_PHASE_TOTAL> phase_ns;
+    /* The CPU time of the whole repaint cycle. */
+    int64_t total_ns = 0;
+    /* The GPU time of the render, overlay, postprocessing and cursors phases,
+     * or -1 if it is unknown (GPU timer queries unsupported or the result is
+     * not available yet). */
+    int64_t gpu_ns = -1;
+};
+
+/**
+ * A histogram of durations with logarithmic buckets. Bucket i contains the
+ * durations in the range [2^i, 2^(i+1)) microseconds, except that the first
+ * bucket also contains shorter durations and the last bucket longer ones.
+ */
+struct frame_timing_histogram_t
+{
+    static constexpr int BUCKETS = 20;
+    std::array<uint64_t, BUCKETS> buckets = {};
+
+    uint64_t count   = 0;
+    int64_t total_ns = 0;
+    int64_t max_ns   = 0;
+
+    /** Add a duration (in nanoseconds) to the histogram. */
+    void add(int64_t duration_ns);
+};
+
+/**
+ * The accumulated time spent in the effect or postprocessing hooks of a
+ * single owner (usually a plugin) in a given stage of the repaint cycle.
+ */
+struct hook_timing_t
+{
+    /* The owner given when the hook was added, or "unnamed". */
+    std::string owner;
+    /* One of "pre", "damage", "overlay", "post" or "postprocess". */
+    std::string stage;
+
+    uint64_t calls   = 0;
+    int64_t total_ns = 0;
+    int64_t max_ns   = 0;
+};
+
+/**
+ * A snapshot of the timing statistics of an output's repaint cycle.
+ */
+struct frame_timing_stats_t
+{
+    /* The last recorded frames, from the oldest to the newest. */
+    std::vector<frame_timing_sample_t> samples;
+
+    /* The distribution of CPU time spent in each phase of rendered frames. */
+    std::array<frame_timing_histogram_t, FRAME_PHASE_TOTAL> phases;
+    /* The distribution of CPU time of whole rendered frames. */
+    frame_timing_histogram_t total;
+    /* The distribution of GPU time of rendered frames. */
+    frame_timing_histogram_t gpu;
+
+    std::vector<hook_timing_t> hooks;
+
+    /* Whether GPU timer queries are supported by the renderer. */
+    bool gpu_timer_available = false;
+};
+}
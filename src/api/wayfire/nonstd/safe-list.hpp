@@ -1,54 +1,159 @@
 #ifndef WF_SAFE_LIST_HPP
 #define WF_SAFE_LIST_HPP
 
-#include <list>
+#include <deque>
 #include <memory>
+#include <optional>
 #include <algorithm>
 #include <functional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
 #include <wayfire/util.hpp>
 
 #include "reverse.hpp"
 
-/* This is a trimmed-down wrapper of std::list<T>.
+/* A list which supports safe iteration over all elements in the collection,
+ * where any element can be added to or deleted from the list at any given time
+ * (i.e even in a for-each-like loop).
  *
- * It supports safe iteration over all elements in the collection, where any
- * element can be deleted from the list at any given time (i.e even in a
- * for-each-like loop) */
+ * Elements are stored contiguously in a vector. While the list is being
+ * iterated, the vector is never resized, so references to elements stay valid:
+ * removed elements are destroyed and leave a tombstone behind, and new elements
+ * are kept in a separate pending queue. When the outermost iteration finishes,
+ * tombstones are compacted and pending elements are moved to their place.
+ *
+ * Each element is tagged with the generation in which it was added. An
+ * iteration visits only the elements which were added before it started. */
 namespace wf
 {
 template<class T>
 class safe_list_t
 {
-    wf::wl_idle_call idle_cleanup;
-    std::list<std::unique_ptr<T>> list;
+  public:
+    enum insert_place_t
+    {
+        INSERT_BEFORE,
+        INSERT_AFTER,
+        INSERT_NONE,
+    };
+
+    using check_t = std::function<insert_place_t(T&)>;
+
+  private:
+    struct slot_t
+    {
+        /* Empty for removed elements */
+        std::optional<T> value;
+        uint64_t generation;
+    };
 
-    /* Remove all invalidated elements in the list */
-    std::function<void()> do_cleanup = [&] ()
+    /* An element added during iteration */
+    struct pending_t
     {
-        auto it = list.begin();
-        while (it != list.end())
+        slot_t slot;
+        /* For elements added with emplace_at(), the check function used to
+         * find their position when they are merged into the list. */
+        check_t check;
+    };
+
+    /* Mutable, so that const iteration can still track its depth and compact
+     * the list when it is done. */
+    mutable std::vector<slot_t> slots;
+    /* A deque, so that pending elements are not moved when more are added. */
+    mutable std::deque<pending_t> pending;
+
+    mutable int iterating = 0;
+    mutable bool has_tombstones = false;
+    size_t alive = 0;
+    uint64_t next_generation = 0;
+
+    /* Tracks the depth of nested iterations, and compacts the list when the
+     * outermost iteration ends, even if the callback throws. */
+    struct iteration_guard_t
+    {
+        const safe_list_t *list;
+        iteration_guard_t(const safe_list_t *list) : list(list)
         {
-            if (*it)
-            {
-                ++it;
-            } else
+            ++list->iterating;
+        }
+
+        ~iteration_guard_t()
+        {
+            if (--list->iterating == 0)
             {
-                it = list.erase(it);
+                list->compact();
             }
         }
     };
 
-    /* Return whether the list has invalidated elements */
-    bool is_dirty() const
+    /* Remove the tombstones and merge the pending elements. Must not be called
+     * during iteration. */
+    void compact() const
     {
-        return idle_cleanup.is_connected();
+        if (has_tombstones)
+        {
+            slots.erase(std::remove_if(slots.begin(), slots.end(),
+                [] (const slot_t& slot) { return !slot.value; }), slots.end());
+            has_tombstones = false;
+        }
+
+        while (!pending.empty())
+        {
+            auto next = std::move(pending.front());
+            pending.pop_front();
+            if (next.slot.value)
+            {
+                insert_slot(std::move(next.slot), next.check);
+            }
+        }
+    }
+
+    void insert_slot(slot_t&& slot, const check_t& check) const
+    {
+        if (check)
+        {
+            for (auto it = slots.begin(); it != slots.end(); ++it)
+            {
+                switch (check(*it->value))
+                {
+                  case INSERT_AFTER:
+                    ++it;
+
+                  // fall through
+                  case INSERT_BEFORE:
+                    slots.insert(it, std::move(slot));
+                    return;
+
+                  default:
+                    break;
+                }
+            }
+        }
+
+        /* If no place found, insert at the end */
+        slots.push_back(std::move(slot));
+    }
+
+    void add(T&& value, check_t check)
+    {
+        slot_t slot{std::move(value), next_generation++};
+        ++alive;
+
+        if (iterating)
+        {
+            pending.push_back({std::move(slot), std::move(check)});
+        } else
+        {
+            insert_slot(std::move(slot), check);
+        }
     }
 
   public:
     safe_list_t()
     {}
 
-    /* Copy the not-erased elements from other, but do not copy the idle source */
+    /* Copy the not-erased elements from other */
     safe_list_t(const safe_list_t& other)
     {
         *this = other;
@@ -56,11 +161,16 @@ class safe_list_t
 
     safe_list_t& operator =(const safe_list_t& other)
     {
-        this->idle_cleanup_source = NULL;
-        other.for_each([&] (auto& el)
+        if (this != &other)
         {
-            this->push_back(el);
-        });
+            clear();
+            other.for_each([&] (T& el)
+            {
+                this->push_back(el);
+            });
+        }
+
+        return *this;
     }
 
     safe_list_t(safe_list_t&& other) = default;
@@ -68,130 +178,110 @@ class safe_list_t
 
     T& back()
     {
-        /* No invalidated elements */
-        if (!is_dirty())
+        for (auto it = pending.rbegin(); it != pending.rend(); ++it)
         {
-            return *list.back();
-        }
-
-        auto it = list.rbegin();
-        while (it != list.rend() && (*it) == nullptr)
-        {
-            ++it;
+            if (it->slot.value)
+            {
+                return *it->slot.value;
+            }
         }
 
-        if (it == list.rend())
+        for (auto it = slots.rbegin(); it != slots.rend(); ++it)
         {
-            throw std::out_of_range("back() called on an empty list!");
+            if (it->value)
+            {
+                return *it->value;
+            }
         }
 
-        return **it;
+        throw std::out_of_range("back() called on an empty list!");
     }
 
     size_t size() const
     {
-        if (!is_dirty())
-        {
-            return list.size();
-        }
-
-        /* Count non-null elements, because that's the real size */
-        size_t sz = 0;
-        for (auto& it : list)
-        {
-            sz += (it != nullptr);
-        }
-
-        return sz;
+        return alive;
     }
 
     /* Push back by copying */
     void push_back(T value)
     {
-        list.push_back(std::make_unique<T>(std::move(value)));
+        add(std::move(value), nullptr);
     }
 
     /* Push back by moving */
     void emplace_back(T&& value)
     {
-        list.push_back(std::make_unique<T>(value));
+        add(std::move(value), nullptr);
     }
 
-    enum insert_place_t
-    {
-        INSERT_BEFORE,
-        INSERT_AFTER,
-        INSERT_NONE,
-    };
-
     /* Insert the given value at a position in the list, determined by the
      * check function. The value is inserted at the first position that
-     * check indicates, or at the end of the list otherwise */
-    void emplace_at(T&& value, std::function<insert_place_t(T&)> check)
+     * check indicates, or at the end of the list otherwise.
+     *
+     * During iteration, the position is determined when the iteration ends. */
+    void emplace_at(T&& value, check_t check)
+    {
+        add(std::move(value), std::move(check));
+    }
+
+    void insert_at(T value, check_t check)
     {
-        auto it = list.begin();
-        while (it != list.end())
+        emplace_at(std::move(value), std::move(check));
+    }
+
+    /* Call func for each non-erased element of the list */
+    template<class Func>
+    void for_each(Func func) const
+    {
+        iteration_guard_t guard{this};
+
+        /* The slots are not resized during iteration, and elements added after
+         * this point are in the pending queue with a newer generation. */
+        const uint64_t generation = next_generation;
+        const size_t nr_slots     = slots.size();
+        for (size_t i = 0; i < nr_slots; i++)
         {
-            /* Skip empty elements */
-            if (*it == nullptr)
+            if (slots[i].value)
             {
-                ++it;
-                continue;
+                func(*slots[i].value);
             }
+        }
 
-            auto place = check(**it);
-            switch (place)
+        for (size_t i = 0; i < pending.size(); i++)
+        {
+            if (pending[i].slot.generation >= generation)
             {
-              case INSERT_AFTER:
-                /* We can safely increment it, because it points to an
-                 * element in the list */
-                ++it;
-
-              // fall through
-              case INSERT_BEFORE:
-                list.emplace(it, std::make_unique<T>(value));
-
-                return;
-
-              default:
                 break;
             }
 
-            ++it;
+            if (pending[i].slot.value)
+            {
+                func(*pending[i].slot.value);
+            }
         }
-
-        /* If no place found, insert at the end */
-        emplace_back(std::move(value));
     }
 
-    void insert_at(T value, std::function<insert_place_t(T&)> check)
+    /* Call func for each non-erased element of the list in reversed order */
+    template<class Func>
+    void for_each_reverse(Func func) const
     {
-        emplace_at(std::move(value), check);
-    }
+        iteration_guard_t guard{this};
 
-    /* Call func for each non-erased element of the list */
-    void for_each(std::function<void(T&)> func) const
-    {
-        /* Go through all elements currently in the list */
-        auto it = list.begin();
-        for (int size = list.size(); size > 0; size--, it++)
+        /* Only elements added by an enclosing iteration can be pending. */
+        const size_t nr_pending = pending.size();
+        for (size_t i = nr_pending; i > 0; i--)
         {
-            if (*it)
+            if (pending[i - 1].slot.value)
             {
-                func(**it);
+                func(*pending[i - 1].slot.value);
             }
         }
-    }
 
-    /* Call func for each non-erased element of the list in reversed order */
-    void for_each_reverse(std::function<void(T&)> func) const
-    {
-        auto it = list.rbegin();
-        for (int size = list.size(); size > 0; size--, it++)
+        for (size_t i = slots.size(); i > 0; i--)
         {
-            if (*it)
+            if (slots[i - 1].value)
             {
-                func(**it);
+                func(*slots[i - 1].value);
             }
         }
     }
@@ -199,7 +289,7 @@ class safe_list_t
     /* Safely remove all elements equal to value */
     void remove_all(const T& value)
     {
-        remove_if([=] (const T& el) { return el == value; });
+        remove_if([&] (const T& el) { return el == value; });
     }
 
     /* Remove all elements from the list */
@@ -209,26 +299,35 @@ class safe_list_t
     }
 
     /* Remove all elements satisfying a given condition.
-     * This function resets their pointers and scheduling a cleanup operation */
-    void remove_if(std::function<bool(const T&)> predicate)
+     * During iteration, removed elements leave a tombstone behind, which is
+     * cleaned up when the iteration ends. */
+    template<class Predicate>
+    void remove_if(Predicate predicate)
     {
-        bool actually_removed = false;
-        for (auto& it : list)
+        auto try_remove = [&] (slot_t& slot)
         {
-            if (it && predicate(*it))
+            if (slot.value && predicate(*slot.value))
             {
-                actually_removed = true;
-                /* First reset the element in the list, and then free resources */
-                auto copy = std::move(it);
-                it = nullptr;
-                /* Now copy goes out of scope */
+                --alive;
+                has_tombstones = true;
+                /* First reset the element in the list, and then free resources
+                 * when the temporary goes out of scope */
+                std::optional<T>{std::exchange(slot.value, std::nullopt)};
             }
+        };
+
+        /* The predicate and the destructors of removed elements may modify the
+         * list, so treat this like an iteration. */
+        iteration_guard_t guard{this};
+        const size_t nr_slots = slots.size();
+        for (size_t i = 0; i < nr_slots; i++)
+        {
+            try_remove(slots[i]);
         }
 
-        /* Schedule a clean-up, but be careful to not schedule it twice */
-        if (!is_dirty() && actually_removed)
+        for (size_t i = 0; i < pending.size(); i++)
         {
-            idle_cleanup.run_once([this] () { this->do_cleanup(); });
+            try_remove(pending[i].slot);
         }
     }
 };
@@ -2,6 +2,8 @@
 #define OBJECT_HPP
 
 #include <typeinfo>
+#include <cstdint>
+#include <functional>
 #include <memory>
 #include <string>
 
@@ -124,6 +126,23 @@ class object_base_t : public signal_provider_t
     /** Get the ID of the object. Each object has a unique ID */
     uint32_t get_id() const;
 
+    /**
+     * Custom data is stored in slots identified by integer keys. Each type
+     * (and each custom name) gets its key once, when it is first used, so
+     * that the typed functions below do not need to construct and hash a
+     * string on every call.
+     *
+     * The typed functions use the same key as the string functions with the
+     * name typeid(T).name(), so both can be used to access the same data.
+     * Data stored under the name of a type must be of that type.
+     */
+    template<class T>
+    static uint32_t custom_data_key()
+    {
+        static const uint32_t key = _register_data_key(typeid(T).name());
+        return key;
+    }
+
     /**
      * Retrieve custom data stored with the given name. If no such data exists,
      * then it is created with the default constructor.
@@ -132,8 +151,7 @@ class object_base_t : public signal_provider_t
      * If your type doesn't have one, use store_data + get_data
      */
     template<class T>
-    nonstd::observer_ptr<T> get_data_safe(
-        std::string name = typeid(T).name())
+    nonstd::observer_ptr<T> get_data_safe(std::string name)
     {
         auto data = get_data<T>(name);
         if (data)
@@ -147,28 +165,58 @@ class object_base_t : public signal_provider_t
         }
     }
 
+    /** Same as get_data_safe(name), with the data stored for the type T. */
+    template<class T>
+    nonstd::observer_ptr<T> get_data_safe()
+    {
+        const uint32_t key = custom_data_key<T>();
+        if (auto data = _find_slot(key))
+        {
+            return nonstd::make_observer(static_cast<T*>(data));
+        }
+
+        auto data = std::make_unique<T>();
+        auto raw  = data.get();
+        _store_slot(key, std::move(data));
+
+        return nonstd::make_observer(raw);
+    }
+
     /* Retrieve custom data stored with the given name. If no such
      * data exists, NULL is returned */
     template<class T>
-    nonstd::observer_ptr<T> get_data(
-        std::string name = typeid(T).name())
+    nonstd::observer_ptr<T> get_data(std::string name)
     {
         return nonstd::make_observer(dynamic_cast<T*>(_fetch_data(name)));
     }
 
+    /* Retrieve custom data stored for the type T, or NULL */
+    template<class T>
+    nonstd::observer_ptr<T> get_data()
+    {
+        return nonstd::make_observer(
+            static_cast<T*>(_find_slot(custom_data_key<T>())));
+    }
+
     /* Assigns the given data to the given name */
     template<class T>
-    void store_data(std::unique_ptr<T> stored_data,
-        std::string name = typeid(T).name())
+    void store_data(std::unique_ptr<T> stored_data, std::string name)
     {
         _store_data(std::move(stored_data), name);
     }
 
+    /* Assigns the given data to the type T */
+    template<class T>
+    void store_data(std::unique_ptr<T> stored_data)
+    {
+        _store_slot(custom_data_key<T>(), std::move(stored_data));
+    }
+
     /* Returns true if there is saved data under the given name */
     template<class T>
     bool has_data()
     {
-        return has_data(typeid(T).name());
+        return _find_slot(custom_data_key<T>()) != nullptr;
     }
 
     /** @return true if there is saved data with the given name */
@@ -181,13 +229,12 @@ class object_base_t : public signal_provider_t
     template<class T>
     void erase_data()
     {
-        erase_data(typeid(T).name());
+        _release_slot(custom_data_key<T>());
     }
 
     /* Erase the saved data from the store and return the pointer */
     template<class T>
-    std::unique_ptr<T> release_data(
-        std::string name = typeid(T).name())
+    std::unique_ptr<T> release_data(std::string name)
     {
         if (!has_data(name))
         {
@@ -199,6 +246,14 @@ class object_base_t : public signal_provider_t
         return std::unique_ptr<T>(dynamic_cast<T*>(stored));
     }
 
+    /* Erase the saved data for the type T from the store and return it */
+    template<class T>
+    std::unique_ptr<T> release_data()
+    {
+        auto stored = _release_slot(custom_data_key<T>());
+        return std::unique_ptr<T>(static_cast<T*>(stored.release()));
+    }
+
     virtual ~object_base_t();
 
     object_base_t(const object_base_t &) = delete;
@@ -213,6 +268,42 @@ class object_base_t : public signal_provider_t
     void _clear_data();
 
   private:
+    /** Get the key of the data type with the given name, see custom_data_key() */
+    static uint32_t _register_data_key(const std::string& name);
+
+    /**
+     * Most objects have only a few pieces of custom data attached, so the
+     * first few slots are stored inline. The rest are kept in obase_priv.
+     */
+    static constexpr int INLINE_DATA_SLOTS = 4;
+    struct data_slot_t
+    {
+        /* 0 for free slots */
+        uint32_t key = 0;
+        std::unique_ptr<custom_data_t> data;
+    };
+
+    data_slot_t inline_data[INLINE_DATA_SLOTS];
+    /* Whether there are slots in obase_priv */
+    bool has_extra_data = false;
+
+    custom_data_t *_find_slot(uint32_t key) const
+    {
+        for (auto& slot : inline_data)
+        {
+            if (slot.key == key)
+            {
+                return slot.data.get();
+            }
+        }
+
+        return has_extra_data ? _find_extra_slot(key) : nullptr;
+    }
+
+    custom_data_t *_find_extra_slot(uint32_t key) const;
+    void _store_slot(uint32_t key, std::unique_ptr<custom_data_t> data);
+    std::unique_ptr<custom_data_t> _release_slot(uint32_t key);
+
     /** Just get the data under the given name, or nullptr, if it does not exist */
     custom_data_t *_fetch_data(std::string name);
     /** Get the data under the given name, and release the pointer, deleting
@@ -2,6 +2,8 @@
 #define WF_OPENGL_HPP
 
 #include <GLES3/gl3.h>
+#include <map>
+#include <string>
 
 #include <wayfire/config/types.hpp>
 #include <wayfire/util.hpp>
@@ -35,12 +37,21 @@ namespace wf
 /* Simple framebuffer, used mostly to allocate framebuffers for workspace
  * streams.
  *
+ * Framebuffers created by allocate() come from a global pool: when they are
+ * released or resized, they are kept for reuse by other framebuffers of the
+ * same size, as long as the released framebuffers stay within the memory
+ * budget of the pool.
+ *
  * Resources (tex/fb) are not automatically destroyed */
 struct framebuffer_t
 {
     GLuint tex = -1, fb = -1;
     int32_t viewport_width = 0, viewport_height = 0;
 
+    /* A static string describing the user of the framebuffer, shown in the
+     * framebuffer pool statistics. */
+    const char *owner = nullptr;
+
     /* The functions below assume they are called between
      * OpenGL::render_begin() and OpenGL::render_end() */
 
@@ -66,6 +77,29 @@ struct framebuffer_t
     void reset();
 };
 
+/* Statistics about the framebuffers allocated with framebuffer_t::allocate() */
+struct framebuffer_pool_stats_t
+{
+    struct usage_t
+    {
+        int count    = 0;
+        size_t bytes = 0;
+    };
+
+    /* Framebuffers currently in use, by owner */
+    std::map<std::string, usage_t> in_use;
+    /* Released framebuffers which are kept for reuse */
+    usage_t idle;
+    /* The configured memory budget for idle framebuffers, in bytes */
+    size_t budget = 0;
+
+    /* Number of framebuffers which were newly created, reused from the pool,
+     * and freed to stay within the budget. */
+    uint64_t created = 0;
+    uint64_t reused  = 0;
+    uint64_t evicted = 0;
+};
+
 /* A more feature-complete framebuffer.
  * It represents an area of the output, with the corresponding dimensions,
  * transforms, etc */
@@ -172,6 +206,9 @@ void render_begin(); // use if you just want to bind GL context but won't draw
 void render_begin(const wf::framebuffer_t& fb);
 void render_begin(int32_t viewport_width, int32_t viewport_height, uint32_t fb);
 
+/* Get the current state of the framebuffer pool, see wf::framebuffer_t */
+wf::framebuffer_pool_stats_t get_framebuffer_pool_stats();
+
 /* Call this to indicate an end of the rendering.
  * Resets bound framebuffer and scissor box.
  * render_end() must be called for each render_begin() */
@@ -277,6 +314,9 @@ GLuint compile_shader(std::string source, GLuint type);
 /**
  * Create an OpenGL program from the given shader sources.
  *
+ * If a binary of the same program was stored in the on-disk shader cache by
+ * the current GL driver, it is loaded instead of compiling the sources.
+ *
  * @param vertex_source The source code of the vertex shader.
  * @param frag_source The source code of the fragment shader.
  */
@@ -291,12 +331,48 @@ GLuint compile_program(std::string vertex_source, std::string frag_source);
  */
 void render_rectangle(wf::geometry_t box, wf::color_t color, glm::mat4 matrix);
 
+/**
+ * A handle to a uniform of a program_t, see program_t::get_uniform().
+ */
+struct uniform_t
+{
+    int index = -1;
+};
+
+/**
+ * A handle to a vertex attribute of a program_t, see program_t::get_attrib().
+ */
+struct attrib_t
+{
+    int index = -1;
+};
+
+/**
+ * Forget the GL state which wayfire assumes is set, see program_t.
+ *
+ * The state is forgotten automatically in render_begin() and render_end().
+ * Code which binds programs or textures directly in between calls to
+ * program_t methods and OpenGL helpers needs to call this afterwards.
+ */
+void invalidate_state_cache();
+
+/**
+ * Get the number of GL calls made with GL_CALL so far.
+ * Useful for debugging, by comparing the values before and after a frame.
+ */
+uint64_t get_gl_call_count();
+
 /**
  * An OpenGL program for rendering texture_t.
  * It contains multiple programs for the different texture types.
  *
  * All of the program_t's functions should only be used inside a rendering
  * block guarded by render_begin/end()
+ *
+ * To avoid redundant GL calls, program_t remembers which program and texture
+ * are bound and which texture coordinate uniforms are set, and skips calls
+ * which would not change them. For the same reason, deactivate() does not
+ * unbind the program.
  */
 class program_t
 {
@@ -323,6 +399,9 @@ class program_t
      *
      * The following identifiers should not be defined in the user source:
      *   _wayfire_texture, _wayfire_uv_scale, _wayfire_y_base, get_pixel
+     *
+     * The program for each texture type is compiled when it is first used, so
+     * errors in the sources are reported then.
      */
     void compile(const std::string& vertex_source,
         const std::string& fragment_source);
@@ -347,6 +426,31 @@ class program_t
     /** @return The program ID for the given texture type, or 0 on failure */
     int get_program_id(wf::texture_type_t type);
 
+    /**
+     * Get a handle for the uniform with the given name.
+     *
+     * Setting a uniform by handle avoids looking up its name, and its location
+     * is queried only once for each texture type. Handles stay valid for the
+     * lifetime of the program_t, even if it is compiled again.
+     */
+    uniform_t get_uniform(const std::string& name);
+
+    /** Get a handle for the vertex attribute with the given name. */
+    attrib_t get_attrib(const std::string& name);
+
+    /** Set the given uniform for the currently used program. */
+    void uniform1i(uniform_t uniform, int value);
+    /** Set the given uniform for the currently used program. */
+    void uniform1f(uniform_t uniform, float value);
+    /** Set the given uniform for the currently used program. */
+    void uniform2f(uniform_t uniform, float x, float y);
+    /** Set the given uniform for the currently used program. */
+    void uniform3f(uniform_t uniform, float x, float y, float z);
+    /** Set the given uniform for the currently used program. */
+    void uniform4f(uniform_t uniform, const glm::vec4& value);
+    /** Set the given uniform for the currently used program. */
+    void uniformMatrix4f(uniform_t uniform, const glm::mat4& value);
+
     /** Set the given uniform for the currently used program. */
     void uniform1i(const std::string& name, int value);
     /** Set the given uniform for the currently used program. */
@@ -369,6 +473,8 @@ class program_t
      */
     void attrib_pointer(const std::string& attrib,
         int size, int stride, const void *ptr, GLenum type = GL_FLOAT);
+    void attrib_pointer(attrib_t attrib,
+        int size, int stride, const void *ptr, GLenum type = GL_FLOAT);
 
     /*
      * Set the attrib divisor. Analogous to glVertexAttribDivisor().
@@ -377,6 +483,7 @@ class program_t
      * @param divisor The divisor value.
      */
     void attrib_divisor(const std::string& attrib, int divisor);
+    void attrib_divisor(attrib_t attrib, int divisor);
 
     /**
      * Set the active texture, and modify the builtin Y-inversion uniforms.
@@ -386,7 +493,7 @@ class program_t
 
     /**
      * Deactivate the vertex attributes activated by attrib_pointer and
-     * attrib_divisor, and reset the active OpenGL program.
+     * attrib_divisor. The program stays bound until another program is used.
      */
     void deactivate();
 
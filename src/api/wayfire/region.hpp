@@ -53,6 +53,21 @@ struct region_t
     region_t& operator ^=(const wlr_box& box);
     region_t& operator ^=(const region_t& other);
 
+    /** @return The number of rectangles the region consists of. */
+    int rect_count() const;
+
+    /**
+     * Simplify the region by replacing nearby rectangles with their bounding
+     * box. The simplified region always contains the original one.
+     *
+     * @param max_overhead Two rectangles are merged if the part of their
+     *   bounding box which neither of them covers is at most this fraction of
+     *   the bounding box's area, for example 0.25.
+     * @param max_rects If positive, rectangles are merged further, regardless
+     *   of @max_overhead, until the region has at most this many rectangles.
+     */
+    void simplify(double max_overhead, int max_rects = 0);
+
     pixman_region32_t *to_pixman();
 
     const pixman_box32_t *begin() const;
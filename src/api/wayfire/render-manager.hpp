@@ -3,6 +3,12 @@
 #include <wayfire/output.hpp>
 #include <wayfire/object.hpp>
 #include <wayfire/region.hpp>
+#include <wayfire/frame-timing.hpp>
+
+namespace OpenGL
+{
+class program_t;
+}
 
 namespace wf
 {
@@ -54,6 +60,46 @@ enum output_effect_type_t
 using post_hook_t = std::function<void (const wf::framebuffer_t& source,
     const wf::framebuffer_t& destination)>;
 
+/**
+ * A point-wise postprocessing effect, that is, an effect which computes each
+ * pixel only from the same pixel of the output image, like color adjustments.
+ *
+ * Post hooks have to process the whole output image, so as long as a post
+ * hook is active, the whole output is repainted each frame. Point-wise effects
+ * in contrast are applied only to the damaged parts of the output, and
+ * consecutive point-wise effects are fused into a single shader pass.
+ *
+ * If the result of the effect changes, for example because an option
+ * changed, the plugin has to damage the whole output.
+ */
+struct pixel_effect_t
+{
+    /**
+     * GLSL ES 1.0 source code of the effect. It has to define a function
+     * `mediump vec4 effect(mediump vec4 color)` which returns the new color of
+     * a pixel with the given color, and may declare uniforms. Since effects are
+     * fused into one shader, uniforms and other global names should be prefixed
+     * with the plugin name.
+     */
+    std::string source;
+
+    /**
+     * Names of the uniforms declared in the source. Their handles are looked
+     * up once for each fused program and passed to set_uniforms.
+     */
+    std::vector<std::string> uniforms;
+
+    /**
+     * Set the uniforms declared in the source. Called each time the effect is
+     * rendered, when the program is already in use.
+     *
+     * @param handles The handles of the uniforms listed in @uniforms, in the
+     *   same order.
+     */
+    std::function<void (OpenGL::program_t& program,
+        const std::vector<OpenGL::uniform_t>& handles)> set_uniforms;
+};
+
 /** Render manager
  *
  * Each output has a render manager, which is responsible for all rendering
@@ -102,8 +148,11 @@ class render_manager : public wf::signal_provider_t
      * Add a new effect hook.
      * @param hook The hook callback
      * @param type The type of the effect hook
+     * @param owner The name under which the time spent in the hook is
+     *   reported in the frame timing statistics, usually the plugin name.
      */
-    void add_effect(effect_hook_t *hook, output_effect_type_t type);
+    void add_effect(effect_hook_t *hook, output_effect_type_t type,
+        const std::string& owner = "");
     /**
      * Remove an added effect hook. No-op if the hook wasn't really added.
      * @param hook The hook callback to be removed
@@ -114,8 +163,10 @@ class render_manager : public wf::signal_provider_t
      * Add a new post hook.
      *
      * @param hook The hook callback
+     * @param owner The name under which the time spent in the hook is
+     *   reported in the frame timing statistics, usually the plugin name.
      */
-    void add_post(post_hook_t *hook);
+    void add_post(post_hook_t *hook, const std::string& owner = "");
 
     /**
      * Remove a post hook. No-op if hook isn't active.
@@ -124,6 +175,21 @@ class render_manager : public wf::signal_provider_t
      */
     void rem_post(post_hook_t *hook);
 
+    /**
+     * Add a new point-wise postprocessing effect. Post hooks and point-wise
+     * effects are applied in the order in which they were added.
+     *
+     * @param effect The effect, which must stay valid until it is removed.
+     * @param owner The name under which the time spent in the effect is
+     *   reported in the frame timing statistics, usually the plugin name.
+     */
+    void add_post(pixel_effect_t *effect, const std::string& owner = "");
+
+    /**
+     * Remove a point-wise postprocessing effect. No-op if it isn't active.
+     */
+    void rem_post(pixel_effect_t *effect);
+
     /**
      * @return The damaged region on the current output for the current
      * frame that is used when swapping buffers. This function should
@@ -179,6 +245,18 @@ class render_manager : public wf::signal_provider_t
      */
     wf::render_target_t get_target_framebuffer() const;
 
+    /**
+     * @return The timings of the last frames of the output, their
+     * distribution per phase of the repaint cycle and the time spent in
+     * effect and post hooks.
+     */
+    wf::frame_timing_stats_t get_frame_timing() const;
+
+    /**
+     * Clear the recorded frame timings.
+     */
+    void reset_frame_timing();
+
   private:
     class impl;
     std::unique_ptr<impl> pimpl;
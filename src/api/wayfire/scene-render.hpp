@@ -2,6 +2,7 @@
 
 #include "wayfire/nonstd/observer_ptr.h"
 #include <memory>
+#include <optional>
 #include <vector>
 #include <wayfire/config/types.hpp>
 #include <wayfire/region.hpp>
@@ -50,6 +51,18 @@ struct render_instruction_t
     wf::region_t damage;
 };
 
+/**
+ * A textured rectangle drawn with the default GL program, see
+ * render_instance_t::get_texture_quad().
+ */
+struct texture_quad_t
+{
+    wf::texture_t texture;
+    /* The geometry of the rectangle, in the coordinate system of the render
+     * target of the instruction. */
+    wf::geometry_t geometry;
+};
+
 /**
  * When (parts) of the scenegraph have to be rendered, they have to be
  * 'instantiated' first. The instantiation of a (sub)tree of the scenegraph
@@ -57,8 +70,10 @@ struct render_instruction_t
  * render trees is to enable damage tracking (each render instance has its own
  * damage), while allowing arbitrary transformations in the scenegraph (e.g. a
  * render instance does not need to export information about how it transforms
- * its children). Due to this design, render trees have to be regenerated every
- * time the relevant portion of the scenegraph changes.
+ * its children). Due to this design, render trees have to be updated every
+ * time the relevant portion of the scenegraph changes. Render instances which
+ * keep the instances of their children may do this incrementally, see
+ * update_instances().
  *
  * Actually painting a render tree (called render pass) is a process involving
  * three steps:
@@ -107,6 +122,21 @@ class render_instance_t
     virtual void render(const wf::render_target_t& target,
         const wf::region_t& region) = 0;
 
+    /**
+     * Render instances whose render() does nothing more than drawing a single
+     * texture with the default GL program may return it here. Consecutive
+     * instructions of such instances are then drawn together in batches,
+     * without calling render(), which saves a lot of GL state changes and draw
+     * calls when many surfaces are visible.
+     *
+     * @return The texture to draw instead of calling render(), or nothing if
+     *   render() should be called. The default implementation returns nothing.
+     */
+    virtual std::optional<texture_quad_t> get_texture_quad()
+    {
+        return {};
+    }
+
     /**
      * Notify the render instance that it has been presented on an output.
      * Note that a render instance may get multiple presentation_feedback calls
@@ -131,6 +161,22 @@ class render_instance_t
         // neither for this node, nor for nodes below.
         return direct_scanout::OCCLUSION;
     }
+
+    /**
+     * Update the render tree after the list of enabled children of @node has
+     * changed. @node is either the node this instance was generated for, or
+     * one of its (indirect) children.
+     *
+     * Render instances which keep the render instances of their children can
+     * use this to regenerate only the part of their render tree which changed.
+     *
+     * @return True if the render instance was updated, false if it needs to be
+     *   regenerated from scratch. The default implementation returns false.
+     */
+    virtual bool update_instances(node_t *node)
+    {
+        return false;
+    }
 };
 
 using render_instance_uptr = std::unique_ptr<render_instance_t>;
@@ -234,6 +280,46 @@ struct render_pass_params_t
 wf::region_t run_render_pass(
     const render_pass_params_t& params, uint32_t flags);
 
+/**
+ * One of the targets of run_multi_target_render_pass().
+ */
+struct render_pass_target_t
+{
+    /** The rendering target. */
+    render_target_t target;
+
+    /**
+     * The damage to repaint on the target, in the coordinate system of the
+     * target. After the render pass, it contains the damage which was actually
+     * repainted: the damage as modified by render-pass-begin handlers, clipped
+     * to the geometry of the target.
+     */
+    region_t damage;
+
+    /** The background color of the target. */
+    color_t background_color;
+};
+
+/**
+ * Render the same instances to several targets which show disjoint parts of
+ * the scene, for example different workspaces of the same output.
+ *
+ * This works like calling run_render_pass() for each target, except that
+ * render instructions are generated only once for the union of all targets,
+ * and then executed on each target whose geometry intersects their damage.
+ * Signals are emitted for each target separately.
+ *
+ * @param instances The instances to render.
+ * @param targets The targets to render to. The geometries of the targets
+ *   must not overlap.
+ * @param reference_output The output for sending presentation feedback, or
+ *   null.
+ * @param flags A combination of render_pass_flags.
+ */
+void run_multi_target_render_pass(std::vector<render_instance_uptr>& instances,
+    std::vector<render_pass_target_t>& targets, wf::output_t *reference_output,
+    uint32_t flags);
+
 /**
  * A helper function for direct scanout implementations.
  * It tries to forward the direct scanout request to the first render instance
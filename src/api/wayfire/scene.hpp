@@ -247,6 +247,36 @@ class node_t : public std::enable_shared_from_this<node_t>,
      */
     wf::geometry_t get_children_bounding_box();
 
+    /**
+     * Get the bounding box of the node, as returned by get_bounding_box().
+     *
+     * The result is cached until the node or one of its (indirect) children
+     * is damaged, that is, until a node_damage_signal is emitted on them.
+     */
+    wf::geometry_t get_cached_bounding_box();
+
+    /**
+     * Invalidate the cached bounding box of the node and of all its ancestors.
+     * This happens automatically when the node is damaged, but nodes whose
+     * bounding box changes without damage need to call it manually.
+     */
+    void invalidate_bounding_box();
+
+    /**
+     * Whether the node accepts input only inside its bounding box, that is,
+     * find_node_at() never returns a result for points outside of
+     * get_bounding_box().
+     *
+     * The default find_node_at() implementation uses this to skip children
+     * whose (cached) bounding box does not contain the input point. Nodes which
+     * may accept input anywhere, for example input grabs, must not override
+     * the default, which is false.
+     */
+    virtual bool has_bounded_input() const
+    {
+        return false;
+    }
+
     /**
      * Structure nodes are special nodes which core usually creates when Wayfire
      * is started (e.g. layer and output nodes). These nodes should not be
@@ -317,6 +347,15 @@ class node_t : public std::enable_shared_from_this<node_t>,
     std::vector<std::shared_ptr<node_t>> children;
 
     void set_children_unchecked(std::vector<node_ptr> new_list);
+
+  private:
+    std::optional<wf::geometry_t> cached_bounding_box;
+    wf::signal::connection_t<node_damage_signal> on_damage_invalidate_bbox;
+
+    // A spatial index of the children, used for hit-testing nodes with many
+    // children. Created lazily, see find_node_at().
+    struct input_index_t;
+    std::unique_ptr<input_index_t> input_index;
 };
 
 /**
@@ -343,6 +382,16 @@ class floating_inner_node_t : public node_t
      * children is updated, and each child's parent is set to this node.
      */
     bool set_children_list(std::vector<node_ptr> new_list);
+
+    /**
+     * Floating inner nodes generate a single render instance which keeps the
+     * render instances of each child separately, so that it can be updated
+     * incrementally when children are added, removed or reordered.
+     */
+    void gen_render_instances(
+        std::vector<render_instance_uptr>& instances,
+        damage_callback push_damage,
+        wf::output_t *output) override;
 };
 using floating_inner_ptr = std::shared_ptr<floating_inner_node_t>;
 
@@ -446,6 +495,12 @@ enum update_flag
 struct root_node_update_signal
 {
     uint32_t flags;
+
+    /**
+     * The node which wf::scene::update() was called with, i.e. the node whose
+     * state changed.
+     */
+    node_t *changed_node;
 };
 
 /**
@@ -3,6 +3,8 @@
 
 #include "wayfire/view.hpp"
 #include "wayfire/output.hpp"
+#include <algorithm>
+#include <set>
 
 /**
  * Documentation of signals emitted from core components.
@@ -134,9 +136,43 @@ struct surface_map_state_changed_signal : public wf::signal_data_t
 /**
  * name: reload-config
  * on: core
- * when: When the config file is reloaded
- * argument: unused
+ * when: When the config file is reloaded. The options whose values changed
+ *   have already been updated, and their callbacks have been called.
+ * argument: A reload_config_signal, or nullptr if any option may have changed.
  */
+struct reload_config_signal : public wf::signal_data_t
+{
+    /** The names of the sections in which at least one option changed. */
+    std::set<std::string> changed_sections;
+};
+
+/**
+ * Check whether a reload-config signal may have changed options in a section.
+ *
+ * @param data The data of the reload-config signal.
+ * @param section The name of the section. If it ends with ':', all sections
+ *   of this object type, for example output:*, are checked.
+ */
+inline bool config_section_changed(wf::signal_data_t *data,
+    const std::string& section)
+{
+    auto ev = dynamic_cast<reload_config_signal*>(data);
+    if (!ev)
+    {
+        return true;
+    }
+
+    if (section.empty() || (section.back() != ':'))
+    {
+        return ev->changed_sections.count(section);
+    }
+
+    return std::any_of(ev->changed_sections.begin(), ev->changed_sections.end(),
+        [&] (const std::string& name)
+    {
+        return name.compare(0, section.size(), section) == 0;
+    });
+}
 
 /**
  * name: keyboard-focus-changed
@@ -1,12 +1,12 @@
 #pragma once
 
+#include <algorithm>
 #include <functional>
 #include <memory>
 #include <unordered_set>
-#include <unordered_map>
+#include <vector>
 #include <wayfire/nonstd/safe-list.hpp>
 #include <cassert>
-#include <typeindex>
 
 namespace wf
 {
@@ -120,6 +120,25 @@ class connection_t final : public connection_base_t
     callback current_callback;
 };
 
+/**
+ * Identifiers of signal types.
+ *
+ * The identifier is the address of a variable which exists once for each
+ * type. Like other inline variables, it is merged between the core and the
+ * plugins, which are loaded with RTLD_GLOBAL. In contrast to the name of the
+ * type, it is distinct for types with the same name in anonymous namespaces
+ * of different plugins. Using RTTI would require a hash map lookup and
+ * dynamic_cast on every emission.
+ */
+namespace detail
+{
+template<class SignalType>
+inline const char signal_type_tag = 0;
+
+template<class SignalType>
+inline constexpr const void *signal_type_id = &signal_type_tag<SignalType>;
+}
+
 class provider_t
 {
   public:
@@ -137,7 +156,15 @@ class provider_t
     template<class SignalType>
     void connect(connection_t<SignalType> *callback)
     {
-        typed_connections[index<SignalType>()].push_back(callback);
+        const void *id = detail::signal_type_id<SignalType>;
+        int idx = find_list(id);
+        if (idx < 0)
+        {
+            idx = typed_connections.size();
+            typed_connections.push_back(connection_list_t{id, {}});
+        }
+
+        typed_connections[idx].connections.push_back(callback);
         callback->connected_to.insert(this);
     }
 
@@ -145,23 +172,59 @@ class provider_t
     void disconnect(connection_base_t *callback)
     {
         callback->connected_to.erase(this);
-        for (auto& [id, connected] : typed_connections)
+        for (auto& list : typed_connections)
         {
-            connected.remove_all(callback);
+            for (auto& connection : list.connections)
+            {
+                if (connection == callback)
+                {
+                    // Connections are not erased immediately, because the
+                    // list might be in the middle of an emission.
+                    connection = nullptr;
+                    list.has_tombstones = true;
+                }
+            }
+
+            if (!list.emitting)
+            {
+                compact(list);
+            }
         }
     }
 
-    /** Emit the given signal. */
+    /**
+     * Emit the given signal.
+     *
+     * Connections added during the emission are not called until the next
+     * emission, connections removed during the emission are not called
+     * anymore.
+     */
     template<class SignalType>
     void emit(SignalType *data)
     {
-        auto& conns = typed_connections[std::type_index(typeid(SignalType))];
-        conns.for_each([&] (connection_base_t *tc)
+        const int idx = find_list(detail::signal_type_id<SignalType>);
+        if (idx < 0)
+        {
+            return;
+        }
+
+        // The list of lists may be reallocated by the callbacks, so we always
+        // access the connections by index.
+        typed_connections[idx].emitting++;
+        const size_t count = typed_connections[idx].connections.size();
+        for (size_t i = 0; i < count; i++)
         {
-            auto real_type = dynamic_cast<connection_t<SignalType>*>(tc);
-            assert(real_type);
-            real_type->emit(data);
-        });
+            if (auto conn = typed_connections[idx].connections[i])
+            {
+                static_cast<connection_t<SignalType>*>(conn)->emit(data);
+            }
+        }
+
+        auto& list = typed_connections[idx];
+        if (--list.emitting == 0)
+        {
+            compact(list);
+        }
     }
 
     provider_t()
@@ -169,12 +232,15 @@ class provider_t
 
     ~provider_t()
     {
-        for (auto& [id, connected] : typed_connections)
+        for (auto& list : typed_connections)
         {
-            connected.for_each([&] (connection_base_t *base)
+            for (auto& connection : list.connections)
             {
-                base->connected_to.erase(this);
-            });
+                if (connection)
+                {
+                    connection->connected_to.erase(this);
+                }
+            }
         }
     }
 
@@ -187,14 +253,46 @@ class provider_t
     provider_t& operator =(provider_t&& other) = delete;
 
   private:
-    template<class SignalType>
-    static inline std::type_index index()
+    /**
+     * The connections to a single signal type, in the order they were added.
+     * Disconnected connections are replaced by null and removed once no
+     * emission of the signal is in progress.
+     */
+    struct connection_list_t
     {
-        return std::type_index(typeid(SignalType));
+        const void *type_id;
+        std::vector<connection_base_t*> connections;
+        int emitting = 0;
+        bool has_tombstones = false;
+    };
+
+    // Objects usually have only a few different signals connected, so a
+    // linear search is faster than hashing.
+    std::vector<connection_list_t> typed_connections;
+
+    int find_list(const void *type_id) const
+    {
+        for (size_t i = 0; i < typed_connections.size(); i++)
+        {
+            if (typed_connections[i].type_id == type_id)
+            {
+                return i;
+            }
+        }
+
+        return -1;
     }
 
-    std::unordered_map<std::type_index, wf::safe_list_t<connection_base_t*>>
-    typed_connections;
+    static void compact(connection_list_t& list)
+    {
+        if (list.has_tombstones)
+        {
+            auto& conns = list.connections;
+            conns.erase(std::remove(conns.begin(), conns.end(), nullptr),
+                conns.end());
+            list.has_tombstones = false;
+        }
+    }
 };
 }
 }
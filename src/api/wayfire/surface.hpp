@@ -5,6 +5,7 @@
 #include <string>
 #include <vector>
 #include <memory>
+#include <optional>
 
 #include <wayfire/nonstd/wlroots.hpp>
 #include <wayfire/nonstd/observer_ptr.h>
@@ -175,6 +176,17 @@ class surface_interface_t : public wf::object_base_t
     virtual void simple_render(const wf::render_target_t& fb, int x, int y,
         const wf::region_t& damage) = 0;
 
+    /**
+     * Get the texture of the surface, if simple_render() does nothing more
+     * than drawing it with the default GL program. Such surfaces may be drawn
+     * together with other surfaces in a single batch during a render pass.
+     *
+     * @return The texture of the surface, or nothing if the surface has no
+     *   buffer or needs custom rendering. The default implementation returns
+     *   nothing.
+     */
+    virtual std::optional<wf::texture_t> get_texture();
+
     /**
      * Get the main node of the surface which contains its content (as opposed
      * to the node which contains content + subsurfaces).
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+
+namespace wf
+{
+/**
+ * A pool of worker threads for CPU-heavy work, like simulations or layout
+ * computations, which can be split into independent parts.
+ *
+ * Each worker has its own queue of tasks. Tasks submitted from a worker go to
+ * its own queue, and idle workers steal tasks from the queues of the others.
+ * A thread waiting for tasks to complete helps execute them, so tasks may
+ * start and wait for other tasks.
+ *
+ * Tasks must not call any compositor functions which are not explicitly
+ * thread-safe. Exceptions thrown by tasks are passed on by
+ * task_group_t::wait().
+ */
+class thread_pool_t
+{
+  public:
+    /**
+     * Get the thread pool of the compositor.
+     *
+     * It has one worker less than the number of CPU cores, because the thread
+     * waiting for the tasks executes them as well, but at most as many as set
+     * by the option core/max_worker_threads.
+     */
+    static thread_pool_t& get();
+
+    /**
+     * Create a new thread pool. The workers are started when the first task
+     * is submitted.
+     *
+     * @param num_workers The number of worker threads. If zero, all tasks are
+     *   executed directly by the thread which submits them.
+     */
+    thread_pool_t(int num_workers);
+
+    /** Waits for all pending tasks and stops the workers. */
+    ~thread_pool_t();
+
+    thread_pool_t(const thread_pool_t&) = delete;
+    thread_pool_t(thread_pool_t&&) = delete;
+    thread_pool_t& operator =(const thread_pool_t&) = delete;
+    thread_pool_t& operator =(thread_pool_t&&) = delete;
+
+    /**
+     * @return The number of threads which execute tasks in parallel,
+     *   including the waiting thread.
+     */
+    int get_concurrency();
+
+    /**
+     * A group of tasks which can be waited for together.
+     */
+    class task_group_t
+    {
+      public:
+        task_group_t(thread_pool_t& pool = thread_pool_t::get());
+
+        /** Waits for the remaining tasks of the group. */
+        ~task_group_t();
+
+        task_group_t(const task_group_t&) = delete;
+        task_group_t(task_group_t&&) = delete;
+        task_group_t& operator =(const task_group_t&) = delete;
+        task_group_t& operator =(task_group_t&&) = delete;
+
+        /** Queue a task to be executed on the pool. */
+        void run(std::function<void()> task);
+
+        /**
+         * Wait until all tasks of the group have finished.
+         * In the meantime, the calling thread executes queued tasks, and once
+         * there are none, it sleeps until the remaining tasks are done.
+         *
+         * If any task threw an exception, the first one is rethrown.
+         */
+        void wait();
+
+      private:
+        thread_pool_t& pool;
+        std::atomic<int> remaining{0};
+
+        /* Protects error, and signals done when remaining drops to zero */
+        std::mutex mutex;
+        std::condition_variable done;
+        std::exception_ptr error;
+
+        void wait_for_tasks();
+    };
+
+    /**
+     * Execute @func for all indices in [@begin, @end), split into ranges which
+     * are executed in parallel. Returns once all ranges are done.
+     *
+     * @param func The function to execute for each range [start, end).
+     * @param grain_size The minimal number of indices per range.
+     */
+    void parallel_for(int begin, int end,
+        const std::function<void(int, int)>& func, int grain_size = 1);
+
+  private:
+    class impl;
+    std::unique_ptr<impl> priv;
+
+    void submit(std::function<void()> task);
+    /** Execute one queued task, if there is any. */
+    bool run_pending_task();
+};
+}
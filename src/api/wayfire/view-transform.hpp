@@ -28,6 +28,58 @@ class zero_copy_texturable_node_t
     }
 };
 
+/**
+ * A transformer node which applies a pure matrix transformation and a color
+ * multiplier (for example alpha) to its children, like view_2d_transformer_t
+ * and view_3d_transformer_t.
+ *
+ * A chain of such transformers on top of a view can be collapsed into a single
+ * transform and drawn directly from the view's texture, instead of rendering
+ * each step of the chain to a temporary buffer, see
+ * render_linear_transformer_chain().
+ */
+class linear_transformer_node_t
+{
+  public:
+    virtual ~linear_transformer_node_t() = default;
+
+    /**
+     * Get the transformation of the node as a matrix which maps points
+     * (x, y, 0, 1) in the coordinate system of the node's children to
+     * homogeneous coordinates in the coordinate system of the node.
+     */
+    virtual glm::mat4 get_linear_transform() = 0;
+
+    /** Get the color multiplier applied to the node's children. */
+    virtual glm::vec4 get_color_multiplier() = 0;
+
+    /**
+     * Whether the node is rendered exactly as described by the transform and
+     * the color multiplier. Only such nodes can be part of a chain.
+     *
+     * Subclasses of linear transformers often render themselves differently,
+     * so the built-in transformers return false for them. Subclasses which
+     * are still linear may override this to return true.
+     */
+    virtual bool is_linear_only()
+    {
+        return false;
+    }
+};
+
+/**
+ * Render the chain of linear transformers starting at @top in a single pass.
+ *
+ * This is possible if every node in the chain has a single child which is a
+ * linear transformer, and the last one has a single child which supports
+ * zero-copy texture generation.
+ *
+ * @return true if the chain was rendered, false if the caller needs to fall
+ *   back to rendering the children to a temporary buffer.
+ */
+bool render_linear_transformer_chain(node_t *top,
+    const wf::render_target_t& target, const wf::region_t& damage);
+
 /**
  * A helper class for implementing transformer nodes.
  * Transformer nodes usually operate on views and implement special effects, like
@@ -83,16 +135,9 @@ class transformer_render_instance_t : public render_instance_t
             {
                 if (auto tex = zcopy->to_texture())
                 {
-                    if (inner_content.fb != (uint) - 1)
-                    {
-                        // Release the inner_content buffer, because we are on
-                        // the zero-copy path and we do not need an auxilliary
-                        // buffer to render to.
-                        OpenGL::render_begin();
-                        inner_content.release();
-                        OpenGL::render_end();
-                    }
-
+                    // We are on the zero-copy path and we do not need an
+                    // auxilliary buffer to render to.
+                    release_inner_content();
                     return *tex;
                 }
             }
@@ -103,6 +148,7 @@ class transformer_render_instance_t : public render_instance_t
         int target_height = scale * bbox.height;
 
         OpenGL::render_begin();
+        inner_content.owner = "transformer";
         if (inner_content.allocate(target_width, target_height))
         {
             cached_damage |= bbox;
@@ -122,6 +168,20 @@ class transformer_render_instance_t : public render_instance_t
         return wf::texture_t{inner_content.tex};
     }
 
+    /**
+     * Release the inner_content buffer, for example when the node's contents
+     * can be rendered without it.
+     */
+    void release_inner_content()
+    {
+        if (inner_content.fb != (uint) - 1)
+        {
+            OpenGL::render_begin();
+            inner_content.release();
+            OpenGL::render_end();
+        }
+    }
+
     void presentation_feedback(wf::output_t *output) override
     {
         for (auto& ch : children)
@@ -276,7 +336,8 @@ class transform_manager_node_t : public wf::scene::floating_inner_node_t
 /**
  * A simple transformer which supports 2D transformations on a view.
  */
-class view_2d_transformer_t : public scene::floating_inner_node_t
+class view_2d_transformer_t : public scene::floating_inner_node_t,
+    public scene::linear_transformer_node_t
 {
   public:
     float scale_x = 1.0f;
@@ -298,6 +359,9 @@ class view_2d_transformer_t : public scene::floating_inner_node_t
     wf::geometry_t get_bounding_box() override;
     void gen_render_instances(std::vector<render_instance_uptr>& instances,
         damage_callback push_damage, wf::output_t *shown_on) override;
+    glm::mat4 get_linear_transform() override;
+    glm::vec4 get_color_multiplier() override;
+    bool is_linear_only() override;
 
     wayfire_view view;
 };
@@ -305,7 +369,8 @@ class view_2d_transformer_t : public scene::floating_inner_node_t
 /**
  * A simple transformer which supports 3D transformations on a view.
  */
-class view_3d_transformer_t : public scene::floating_inner_node_t
+class view_3d_transformer_t : public scene::floating_inner_node_t,
+    public scene::linear_transformer_node_t
 {
   protected:
     wayfire_view view;
@@ -324,6 +389,9 @@ class view_3d_transformer_t : public scene::floating_inner_node_t
     wf::geometry_t get_bounding_box() override;
     void gen_render_instances(std::vector<render_instance_uptr>& instances,
         damage_callback push_damage, wf::output_t *shown_on) override;
+    glm::mat4 get_linear_transform() override;
+    glm::vec4 get_color_multiplier() override;
+    bool is_linear_only() override;
 
     static const float fov; // PI / 8
     static glm::mat4 default_view_matrix();
@@ -508,6 +508,11 @@ class view_node_t : public scene::floating_inner_node_t,
     std::optional<wf::texture_t> to_texture() const override;
     wf::geometry_t get_bounding_box() override;
 
+    bool has_bounded_input() const override
+    {
+        return true;
+    }
+
   protected:
     view_node_t();
     wayfire_view view;
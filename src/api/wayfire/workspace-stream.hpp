@@ -50,7 +50,66 @@ class workspace_stream_t
      */
     void stop();
 
+    /**
+     * Set the resolution of the stream relative to the resolution of the
+     * output, for users which display the workspace scaled down.
+     *
+     * The scale is rounded up to a power of two (1, 1/2, 1/4, ...), so that
+     * zooming does not re-render the whole workspace on every frame.
+     * Changing the scale triggers a full repaint on the next render_frame().
+     */
+    void set_scale(float scale);
+
+    /** Get the current (rounded) scale of the stream. */
+    float get_scale() const;
+
+    /** The lowest scale a stream can have. */
+    static constexpr float MIN_SCALE = 1.0 / 8;
+
   private:
     void update_instances();
+
+    float scale = 1.0;
+
+    /** The size of the buffer at the current scale. */
+    wf::dimensions_t get_buffer_size(wf::output_t *output) const;
+
+    /** Allocate the buffer and get a render target for it. */
+    wf::render_target_t prepare_target(wf::output_t *output);
+    wf::color_t get_background_color() const;
+
+    friend class workspace_stream_renderer_t;
+};
+
+/**
+ * Renders the streams of several workspaces of the same output with a single
+ * set of render instances, see scene::run_multi_target_render_pass().
+ *
+ * In contrast to rendering each stream with render_frame(), the render
+ * instances are generated and scheduled once for all workspaces. The streams
+ * do not need to be started.
+ *
+ * The renderer tracks damage only while it exists, so the first render()
+ * repaints the given streams fully.
+ */
+class workspace_stream_renderer_t
+{
+  public:
+    workspace_stream_renderer_t(wf::output_t *output);
+
+    /**
+     * Update the contents of the given streams, which must belong to
+     * different workspaces of the output.
+     */
+    void render(const std::vector<workspace_stream_t*>& streams);
+
+  private:
+    wf::output_t *output;
+    std::vector<scene::render_instance_uptr> instances;
+
+    /* Damage on all workspaces which has not been rendered yet. */
+    wf::region_t damage;
+    signal::connection_t<scene::root_node_update_signal> on_root_update;
+    void update_instances();
 };
 }
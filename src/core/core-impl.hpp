@@ -18,6 +18,7 @@ namespace wf
 class seat_t;
 class input_manager_t;
 class input_method_relay;
+class process_launcher_t;
 class compositor_core_impl_t : public compositor_core_t
 {
   public:
@@ -34,6 +35,7 @@ class compositor_core_impl_t : public compositor_core_t
     std::unique_ptr<seat_t> seat;
     std::unique_ptr<wf::input_manager_t> input;
     std::unique_ptr<input_method_relay> im_relay;
+    std::unique_ptr<process_launcher_t> launcher;
 
     /**
      * Initialize the compositor core.
@@ -1,11 +1,4 @@
-/* Needed for pipe2 */
-#ifndef _GNU_SOURCE
-    #define _GNU_SOURCE
-#endif
-
-#include <sys/wait.h>
 #include <unistd.h>
-#include <fcntl.h>
 #include <float.h>
 
 #include <wayfire/img.hpp>
@@ -32,6 +25,7 @@
 #include "../output/gtk-shell.hpp"
 #include "main.hpp"
 #include "seat/drag-icon.hpp"
+#include "launcher.hpp"
 
 #include "core-impl.hpp"
 
@@ -164,6 +158,7 @@ struct wlr_idle_inhibitor_t : public wf::idle_inhibitor_t
 void wf::compositor_core_impl_t::init()
 {
     this->scene_root = std::make_shared<scene::root_node_t>();
+    this->launcher   = std::make_unique<wf::process_launcher_t>();
 
     wlr_renderer_init_wl_display(renderer, display);
 
@@ -616,59 +611,20 @@ wayfire_view wf::compositor_core_impl_t::find_view(const std::string& id)
 
 pid_t wf::compositor_core_impl_t::run(std::string command)
 {
-    static constexpr size_t READ_END  = 0;
-    static constexpr size_t WRITE_END = 1;
-    pid_t pid;
-    int pipe_fd[2];
-    pipe2(pipe_fd, O_CLOEXEC);
-
-    /* The following is a "hack" for disowning the child processes,
-     * otherwise they will simply stay as zombie processes */
-    pid = fork();
-    if (!pid)
-    {
-        pid = fork();
-        if (!pid)
-        {
-            close(pipe_fd[READ_END]);
-            close(pipe_fd[WRITE_END]);
+    std::map<std::string, std::string> env = {
+        {"_JAVA_AWT_WM_NONREPARENTING", "1"},
+        {"WAYLAND_DISPLAY", wayland_display},
+    };
 
-            setenv("_JAVA_AWT_WM_NONREPARENTING", "1", 1);
-            setenv("WAYLAND_DISPLAY", wayland_display.c_str(), 1);
 #if WF_HAS_XWAYLAND
-            if (!xwayland_get_display().empty())
-            {
-                setenv("DISPLAY", xwayland_get_display().c_str(), 1);
-            }
-
-#endif
-            int dev_null = open("/dev/null", O_WRONLY);
-            dup2(dev_null, 1);
-            dup2(dev_null, 2);
-            close(dev_null);
-
-            _exit(execl("/bin/sh", "/bin/sh", "-c", command.c_str(), NULL));
-        } else
-        {
-            close(pipe_fd[READ_END]);
-            write(pipe_fd[WRITE_END], (void*)(&pid), sizeof(pid));
-            close(pipe_fd[WRITE_END]);
-            _exit(0);
-        }
-    } else
+    if (!xwayland_get_display().empty())
     {
-        close(pipe_fd[WRITE_END]);
-
-        int status;
-        waitpid(pid, &status, 0);
-
-        pid_t child_pid;
-        read(pipe_fd[READ_END], &child_pid, sizeof(child_pid));
+        env["DISPLAY"] = xwayland_get_display();
+    }
 
-        close(pipe_fd[READ_END]);
+#endif
 
-        return child_pid;
-    }
+    return launcher->spawn(command, env);
 }
 
 std::string wf::compositor_core_impl_t::get_xwayland_display()
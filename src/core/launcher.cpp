@@ -0,0 +1,136 @@
+#include "launcher.hpp"
+#include <wayfire/core.hpp>
+#include <wayfire/util/log.hpp>
+#include <wayland-server.h>
+
+#include <chrono>
+#include <cstring>
+#include <vector>
+#include <fcntl.h>
+#include <signal.h>
+#include <spawn.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+extern char **environ;
+
+namespace wf
+{
+process_launcher_t::process_launcher_t()
+{
+    // The signal is blocked and read from a signalfd, so this has to happen
+    // before any other threads are started.
+    on_sigchld = wl_event_loop_add_signal(wf::get_core().ev_loop, SIGCHLD,
+        [] (int signal, void *data)
+    {
+        ((process_launcher_t*)data)->reap_exited_children();
+        return 0;
+    }, this);
+
+    on_loop_destroy.self = this;
+    on_loop_destroy.listener.notify = [] (wl_listener *listener, void*)
+    {
+        loop_destroy_listener_t *wrap = wl_container_of(listener, wrap, listener);
+        wl_list_remove(&wrap->listener.link);
+        wl_list_init(&wrap->listener.link);
+        wrap->self->remove_sigchld_source();
+    };
+    wl_event_loop_add_destroy_listener(wf::get_core().ev_loop,
+        &on_loop_destroy.listener);
+}
+
+process_launcher_t::~process_launcher_t()
+{
+    wl_list_remove(&on_loop_destroy.listener.link);
+    remove_sigchld_source();
+}
+
+void process_launcher_t::remove_sigchld_source()
+{
+    if (on_sigchld)
+    {
+        wl_event_source_remove(on_sigchld);
+        on_sigchld = nullptr;
+    }
+}
+
+void process_launcher_t::reap_exited_children()
+{
+    // Only wait for our own children, other parts of the compositor (like
+    // Xwayland in wlroots) wait for theirs.
+    for (auto it = children.begin(); it != children.end();)
+    {
+        if (waitpid(*it, NULL, WNOHANG) != 0)
+        {
+            it = children.erase(it);
+        } else
+        {
+            ++it;
+        }
+    }
+}
+
+pid_t process_launcher_t::spawn(const std::string& command,
+    const std::map<std::string, std::string>& env)
+{
+    std::vector<std::string> env_strings;
+    for (char **var = environ; *var; var++)
+    {
+        std::string str = *var;
+        if (!env.count(str.substr(0, str.find('='))))
+        {
+            env_strings.push_back(str);
+        }
+    }
+
+    for (auto& [name, value] : env)
+    {
+        env_strings.push_back(name + "=" + value);
+    }
+
+    std::vector<char*> envp;
+    for (auto& str : env_strings)
+    {
+        envp.push_back(str.data());
+    }
+
+    envp.push_back(nullptr);
+
+    const char *argv[] = {"/bin/sh", "-c", command.c_str(), nullptr};
+
+    posix_spawn_file_actions_t actions;
+    posix_spawn_file_actions_init(&actions);
+    posix_spawn_file_actions_addopen(&actions, 1, "/dev/null", O_WRONLY, 0);
+    posix_spawn_file_actions_adddup2(&actions, 1, 2);
+
+    // SIGCHLD is blocked in the compositor, do not pass that on
+    posix_spawnattr_t attr;
+    posix_spawnattr_init(&attr);
+    sigset_t mask;
+    sigemptyset(&mask);
+    posix_spawnattr_setsigmask(&attr, &mask);
+    posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGMASK);
+
+    auto start = std::chrono::steady_clock::now();
+    pid_t pid;
+    int err = posix_spawn(&pid, "/bin/sh", &actions, &attr,
+        (char**)argv, envp.data());
+    auto elapsed = std::chrono::steady_clock::now() - start;
+
+    posix_spawnattr_destroy(&attr);
+    posix_spawn_file_actions_destroy(&actions);
+
+    if (err != 0)
+    {
+        LOGE("Failed to run \"", command, "\": ", strerror(err));
+        return -1;
+    }
+
+    LOGD("Started process ", pid, " in ",
+        std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count() / 1000.0,
+        "ms: ", command);
+
+    children.insert(pid);
+    return pid;
+}
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <map>
+#include <set>
+#include <string>
+#include <sys/types.h>
+#include <wayland-server.h>
+
+namespace wf
+{
+/**
+ * Starts client processes without blocking the event loop.
+ *
+ * Processes are started with posix_spawn(), which does not copy the address
+ * space of the compositor. The started processes are children of the
+ * compositor, so the launcher reaps them on SIGCHLD when they exit.
+ *
+ * Has to be created before any threads are started, see the constructor.
+ */
+class process_launcher_t
+{
+  public:
+    process_launcher_t();
+    ~process_launcher_t();
+
+    /**
+     * Run @command with /bin/sh, with stdout and stderr redirected to
+     * /dev/null.
+     *
+     * @param env Environment variables to set in addition to the environment
+     *   of the compositor.
+     * @return The PID of the new process, or -1 on failure.
+     */
+    pid_t spawn(const std::string& command,
+        const std::map<std::string, std::string>& env);
+
+  private:
+    std::set<pid_t> children;
+    wl_event_source *on_sigchld = nullptr;
+
+    /* The launcher is destroyed with core, after the event loop */
+    struct loop_destroy_listener_t
+    {
+        wl_listener listener;
+        process_launcher_t *self;
+    } on_loop_destroy;
+
+    void remove_sigchld_source();
+    void reap_exited_children();
+};
+}
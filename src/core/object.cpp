@@ -2,6 +2,7 @@
 #include "wayfire/nonstd/safe-list.hpp"
 #include <unordered_map>
 #include <set>
+#include <vector>
 
 #include <wayfire/signal-provider.hpp>
 
@@ -119,7 +120,15 @@ void wf::signal_provider_t::disconnect_signal(signal_connection_t *connection)
 /* Emit the given signal. No type checking for data is required */
 void wf::signal_provider_t::emit_signal(std::string name, wf::signal_data_t *data)
 {
-    sprovider_priv->signals[name].for_each([data] (auto call)
+    // Do not use operator[], it would allocate a new list for every signal
+    // which is emitted but has no connections.
+    auto it = sprovider_priv->signals.find(name);
+    if (it == sprovider_priv->signals.end())
+    {
+        return;
+    }
+
+    it->second.for_each([data] (auto call)
     {
         call->emit(data);
     });
@@ -128,10 +137,40 @@ void wf::signal_provider_t::emit_signal(std::string name, wf::signal_data_t *dat
 class wf::object_base_t::obase_impl
 {
   public:
-    std::unordered_map<std::string, std::unique_ptr<custom_data_t>> data;
+    /* Slots which did not fit in object_base_t::inline_data */
+    std::unordered_map<uint32_t, std::unique_ptr<custom_data_t>> extra_data;
     uint32_t object_id;
 };
 
+/* All names which were assigned a key, see custom_data_key(). */
+static std::unordered_map<std::string, uint32_t>& data_keys()
+{
+    static std::unordered_map<std::string, uint32_t> keys;
+    return keys;
+}
+
+/* Get the key of an already registered name, or 0 */
+static uint32_t find_data_key(const std::string& name)
+{
+    auto it = data_keys().find(name);
+    return it == data_keys().end() ? 0 : it->second;
+}
+
+uint32_t wf::object_base_t::_register_data_key(const std::string& name)
+{
+    auto& keys = data_keys();
+    auto it    = keys.find(name);
+    if (it != keys.end())
+    {
+        return it->second;
+    }
+
+    // Key 0 marks free slots.
+    const uint32_t key = keys.size() + 1;
+    keys[name] = key;
+    return key;
+}
+
 wf::object_base_t::object_base_t()
 {
     this->obase_priv = std::make_unique<obase_impl>();
@@ -140,7 +179,10 @@ wf::object_base_t::object_base_t()
     obase_priv->object_id = global_id++;
 }
 
-wf::object_base_t::~object_base_t() = default;
+wf::object_base_t::~object_base_t()
+{
+    _clear_data();
+}
 
 std::string wf::object_base_t::to_string() const
 {
@@ -152,44 +194,112 @@ uint32_t wf::object_base_t::get_id() const
     return obase_priv->object_id;
 }
 
-bool wf::object_base_t::has_data(std::string name)
+wf::custom_data_t*wf::object_base_t::_find_extra_slot(uint32_t key) const
 {
-    return obase_priv->data[name] != nullptr;
+    auto it = obase_priv->extra_data.find(key);
+    return it == obase_priv->extra_data.end() ? nullptr : it->second.get();
 }
 
-void wf::object_base_t::erase_data(std::string name)
+void wf::object_base_t::_store_slot(uint32_t key,
+    std::unique_ptr<custom_data_t> data)
 {
-    auto data = std::move(obase_priv->data[name]);
-    obase_priv->data.erase(name);
-    data.reset();
+    // Destroy the previously stored data, if any, only after the new data is
+    // in place.
+    auto previous = _release_slot(key);
+
+    for (auto& slot : inline_data)
+    {
+        if (slot.key == 0)
+        {
+            slot.key  = key;
+            slot.data = std::move(data);
+            return;
+        }
+    }
+
+    obase_priv->extra_data[key] = std::move(data);
+    has_extra_data = true;
 }
 
-wf::custom_data_t*wf::object_base_t::_fetch_data(std::string name)
+std::unique_ptr<wf::custom_data_t> wf::object_base_t::_release_slot(uint32_t key)
 {
-    auto it = obase_priv->data.find(name);
-    if (it == obase_priv->data.end())
+    for (auto& slot : inline_data)
+    {
+        if (slot.key == key)
+        {
+            slot.key = 0;
+            return std::move(slot.data);
+        }
+    }
+
+    if (!has_extra_data)
     {
         return nullptr;
     }
 
-    return it->second.get();
+    auto& extra = obase_priv->extra_data;
+    auto it     = extra.find(key);
+    if (it == extra.end())
+    {
+        return nullptr;
+    }
+
+    auto data = std::move(it->second);
+    extra.erase(it);
+    has_extra_data = !extra.empty();
+    return data;
 }
 
-wf::custom_data_t*wf::object_base_t::_fetch_erase(std::string name)
+bool wf::object_base_t::has_data(std::string name)
 {
-    auto data = obase_priv->data[name].release();
-    erase_data(name);
+    return _fetch_data(name) != nullptr;
+}
 
-    return data;
+void wf::object_base_t::erase_data(std::string name)
+{
+    if (const uint32_t key = find_data_key(name))
+    {
+        _release_slot(key).reset();
+    }
+}
+
+wf::custom_data_t*wf::object_base_t::_fetch_data(std::string name)
+{
+    const uint32_t key = find_data_key(name);
+    return key ? _find_slot(key) : nullptr;
+}
+
+wf::custom_data_t*wf::object_base_t::_fetch_erase(std::string name)
+{
+    const uint32_t key = find_data_key(name);
+    return key ? _release_slot(key).release() : nullptr;
 }
 
 void wf::object_base_t::_store_data(std::unique_ptr<wf::custom_data_t> data,
     std::string name)
 {
-    obase_priv->data[name] = std::move(data);
+    _store_slot(_register_data_key(name), std::move(data));
 }
 
 void wf::object_base_t::_clear_data()
 {
-    obase_priv->data.clear();
+    // Move all data out first, so that destructors of custom data do not see
+    // a half-cleared object.
+    std::vector<std::unique_ptr<custom_data_t>> cleared;
+    for (auto& slot : inline_data)
+    {
+        if (slot.key)
+        {
+            slot.key = 0;
+            cleared.push_back(std::move(slot.data));
+        }
+    }
+
+    for (auto& [key, data] : obase_priv->extra_data)
+    {
+        cleared.push_back(std::move(data));
+    }
+
+    obase_priv->extra_data.clear();
+    has_extra_data = false;
 }
@@ -3,6 +3,8 @@
 
 #include <wayfire/opengl.hpp>
 #include <wayfire/output.hpp>
+#include <wayfire/region.hpp>
+#include <vector>
 
 namespace OpenGL
 {
@@ -14,6 +16,68 @@ void fini();
 void bind_output(wf::output_t *output, uint32_t fb);
 /** Indicate the output frame has been finished */
 void unbind_output(wf::output_t *output);
+
+/**
+ * Create a program from the binary stored in the on-disk shader cache.
+ *
+ * @return The linked program, or 0 if there is no usable binary.
+ */
+GLuint load_program_binary(const std::string& vertex_source,
+    const std::string& frag_source);
+
+/** Store the binary of a linked program in the on-disk shader cache. */
+void save_program_binary(GLuint program, const std::string& vertex_source,
+    const std::string& frag_source);
+
+/**
+ * Collects textured rectangles and draws them with the default program.
+ *
+ * Instead of scissoring, the rectangles are clipped to the damage on the CPU,
+ * so that all of them can be stored in a single vertex buffer. The program is
+ * bound once for each run of textures of the same type, and each texture is
+ * drawn with a single draw call.
+ */
+class texture_batch_t
+{
+  public:
+    /**
+     * Add the parts of a textured rectangle which intersect the damage.
+     *
+     * @param texture The texture to draw.
+     * @param geometry The geometry of the rectangle, in the coordinate system
+     *   of @target.
+     * @param target The render target whose projection is used.
+     * @param damage The region to draw, in the coordinate system of @target.
+     */
+    void add(const wf::texture_t& texture, const wf::geometry_t& geometry,
+        const wf::render_target_t& target, const wf::region_t& damage);
+
+    /**
+     * Draw all rectangles on the given target and clear the batch.
+     * All rectangles must have been added with targets using the same
+     * framebuffer as @target.
+     *
+     * @return The number of draw calls which were issued.
+     */
+    int draw(const wf::render_target_t& target);
+
+    bool empty() const
+    {
+        return ranges.empty();
+    }
+
+  private:
+    struct range_t
+    {
+        wf::texture_t texture;
+        int first;
+        int count;
+    };
+
+    std::vector<range_t> ranges;
+    std::vector<GLfloat> vertices;
+    std::vector<GLfloat> uvs;
+};
 }
 
 #endif /* end of include guard: WF_OPENGL_PRIV_HPP */
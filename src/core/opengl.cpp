@@ -1,9 +1,12 @@
 #include <wayfire/util/log.hpp>
 #include <map>
+#include <list>
+#include <algorithm>
 #include "opengl-priv.hpp"
 #include "wayfire/output.hpp"
 #include "core-impl.hpp"
 #include "config.h"
+#include <wayfire/option-wrapper.hpp>
 #include <wayfire/nonstd/wlroots-full.hpp>
 
 #include <glm/gtc/matrix_transform.hpp>
@@ -31,8 +34,11 @@ const char *gl_error_string(const GLenum err)
 }
 
 static bool disable_gl_call = false;
+static uint64_t gl_call_count = 0;
 void gl_call(const char *func, uint32_t line, const char *glfunc)
 {
+    ++gl_call_count;
+
     GLenum err;
     if (disable_gl_call || ((err = glGetError()) == GL_NO_ERROR))
     {
@@ -45,6 +51,11 @@ void gl_call(const char *func, uint32_t line, const char *glfunc)
 
 namespace OpenGL
 {
+uint64_t get_gl_call_count()
+{
+    return gl_call_count;
+}
+
 /*
  * Different Context is kept for each output
  * Each of the following functions uses the currently bound context
@@ -78,17 +89,31 @@ GLuint compile_shader(std::string source, GLuint type)
 /* Create a very simple gl program from the given shader sources */
 GLuint compile_program(std::string vertex_source, std::string frag_source)
 {
+    if (GLuint cached = load_program_binary(vertex_source, frag_source))
+    {
+        return cached;
+    }
+
     auto vertex_shader   = compile_shader(vertex_source, GL_VERTEX_SHADER);
     auto fragment_shader = compile_shader(frag_source, GL_FRAGMENT_SHADER);
     auto result_program  = GL_CALL(glCreateProgram());
     GL_CALL(glAttachShader(result_program, vertex_shader));
     GL_CALL(glAttachShader(result_program, fragment_shader));
+    GL_CALL(glProgramParameteri(result_program,
+        GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE));
     GL_CALL(glLinkProgram(result_program));
 
     /* won't be really deleted until program is deleted as well */
     GL_CALL(glDeleteShader(vertex_shader));
     GL_CALL(glDeleteShader(fragment_shader));
 
+    GLint status = GL_FALSE;
+    GL_CALL(glGetProgramiv(result_program, GL_LINK_STATUS, &status));
+    if (status == GL_TRUE)
+    {
+        save_program_binary(result_program, vertex_source, frag_source);
+    }
+
     return result_program;
 }
 
@@ -172,11 +197,16 @@ void render_transformed_texture(wf::texture_t tex,
         final_texg.x1, final_texg.y2,
     };
 
+    static const auto position      = program.get_attrib("position");
+    static const auto uv_position   = program.get_attrib("uvPosition");
+    static const auto mvp           = program.get_uniform("MVP");
+    static const auto color_uniform = program.get_uniform("color");
+
     program.set_active_texture(tex);
-    program.attrib_pointer("position", 2, 0, vertexData.data());
-    program.attrib_pointer("uvPosition", 2, 0, coordData.data());
-    program.uniformMatrix4f("MVP", model);
-    program.uniform4f("color", color);
+    program.attrib_pointer(position, 2, 0, vertexData.data());
+    program.attrib_pointer(uv_position, 2, 0, coordData.data());
+    program.uniformMatrix4f(mvp, model);
+    program.uniform4f(color_uniform, color);
 
     GL_CALL(glEnable(GL_BLEND));
     GL_CALL(glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA));
@@ -237,9 +267,13 @@ void render_rectangle(wf::geometry_t geometry, wf::color_t color,
         x, y,
     };
 
-    color_program.attrib_pointer("position", 2, 0, vertexData);
-    color_program.uniformMatrix4f("MVP", matrix);
-    color_program.uniform4f("color", {color.r, color.g, color.b, color.a});
+    static const auto position      = color_program.get_attrib("position");
+    static const auto mvp           = color_program.get_uniform("MVP");
+    static const auto color_uniform = color_program.get_uniform("color");
+
+    color_program.attrib_pointer(position, 2, 0, vertexData);
+    color_program.uniformMatrix4f(mvp, matrix);
+    color_program.uniform4f(color_uniform, {color.r, color.g, color.b, color.a});
 
     GL_CALL(glEnable(GL_BLEND));
     GL_CALL(glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA));
@@ -248,6 +282,128 @@ void render_rectangle(wf::geometry_t geometry, wf::color_t color,
     color_program.deactivate();
 }
 
+static bool same_texture(const wf::texture_t& a, const wf::texture_t& b)
+{
+    return a.tex_id == b.tex_id && a.target == b.target && a.type == b.type &&
+           a.invert_y == b.invert_y && a.has_viewport == b.has_viewport &&
+           (!a.has_viewport ||
+               (a.viewport_box.x1 == b.viewport_box.x1 &&
+                   a.viewport_box.y1 == b.viewport_box.y1 &&
+                   a.viewport_box.x2 == b.viewport_box.x2 &&
+                   a.viewport_box.y2 == b.viewport_box.y2));
+}
+
+void texture_batch_t::add(const wf::texture_t& texture,
+    const wf::geometry_t& geometry, const wf::render_target_t& target,
+    const wf::region_t& damage)
+{
+    if ((geometry.width <= 0) || (geometry.height <= 0))
+    {
+        return;
+    }
+
+    const int first = vertices.size() / 2;
+    const auto projection = target.get_orthographic_projection();
+    auto push_vertex = [&] (float x, float y)
+    {
+        auto clip = projection * glm::vec4{x, y, 0.0, 1.0};
+        vertices.push_back(clip.x);
+        vertices.push_back(clip.y);
+
+        // Same convention as render_transformed_texture(): the bottom edge of
+        // the geometry corresponds to v = 0.
+        uvs.push_back((x - geometry.x) / geometry.width);
+        uvs.push_back(1.0f - (y - geometry.y) / geometry.height);
+    };
+
+    for (const auto& rect : damage)
+    {
+        auto box = wf::geometry_intersection(
+            wlr_box_from_pixman_box(rect), geometry);
+        if ((box.width <= 0) || (box.height <= 0))
+        {
+            continue;
+        }
+
+        float x1 = box.x, y1 = box.y;
+        float x2 = box.x + box.width, y2 = box.y + box.height;
+        push_vertex(x1, y1);
+        push_vertex(x2, y1);
+        push_vertex(x2, y2);
+        push_vertex(x1, y1);
+        push_vertex(x2, y2);
+        push_vertex(x1, y2);
+    }
+
+    const int count = vertices.size() / 2 - first;
+    if (count == 0)
+    {
+        return;
+    }
+
+    if (!ranges.empty() && same_texture(ranges.back().texture, texture))
+    {
+        ranges.back().count += count;
+    } else
+    {
+        ranges.push_back(range_t{texture, first, count});
+    }
+}
+
+int texture_batch_t::draw(const wf::render_target_t& target)
+{
+    if (ranges.empty())
+    {
+        return 0;
+    }
+
+    // Use GL_NEAREST for integer scale, like wlr_surface_base_t does.
+    const bool nearest = (target.scale - floor(target.scale) < 0.001);
+
+    render_begin(target);
+    int active_type = -1;
+    for (auto& range : ranges)
+    {
+        if (range.texture.type != active_type)
+        {
+            if (active_type >= 0)
+            {
+                program.deactivate();
+            }
+
+            static const auto position      = program.get_attrib("position");
+            static const auto uv_position   = program.get_attrib("uvPosition");
+            static const auto mvp           = program.get_uniform("MVP");
+            static const auto color_uniform = program.get_uniform("color");
+
+            active_type = range.texture.type;
+            program.use(range.texture.type);
+            program.attrib_pointer(position, 2, 0, vertices.data());
+            program.attrib_pointer(uv_position, 2, 0, uvs.data());
+            program.uniformMatrix4f(mvp, glm::mat4(1.0));
+            program.uniform4f(color_uniform, glm::vec4(1.0));
+        }
+
+        program.set_active_texture(range.texture);
+        if (nearest)
+        {
+            GL_CALL(glTexParameteri(range.texture.target,
+                GL_TEXTURE_MAG_FILTER, GL_NEAREST));
+        }
+
+        GL_CALL(glDrawArrays(GL_TRIANGLES, range.first, range.count));
+    }
+
+    program.deactivate();
+    render_end();
+
+    const int draw_calls = ranges.size();
+    ranges.clear();
+    vertices.clear();
+    uvs.clear();
+    return draw_calls;
+}
+
 static bool egl_make_current(struct wlr_egl *egl)
 {
     if (!eglMakeCurrent(wlr_egl_get_display(egl), EGL_NO_SURFACE, EGL_NO_SURFACE,
@@ -274,6 +430,7 @@ void render_begin()
 
     GL_CALL(glEnable(GL_BLEND));
     GL_CALL(glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA));
+    invalidate_state_cache();
 }
 
 void render_begin(const wf::framebuffer_t& fb)
@@ -300,6 +457,7 @@ void render_end()
 {
     GL_CALL(glBindFramebuffer(GL_FRAMEBUFFER, current_output_fb));
     GL_CALL(glDisable(GL_SCISSOR_TEST));
+    invalidate_state_cache();
 }
 }
 
@@ -325,20 +483,211 @@ static std::string framebuffer_status_to_str(
     }
 }
 
-bool wf::framebuffer_t::allocate(int width, int height)
+namespace
+{
+/**
+ * Keeps the framebuffers created by wf::framebuffer_t::allocate().
+ *
+ * Framebuffers are reused only for the exact same size, because users sample
+ * the whole texture and a larger one would show garbage at the edges. Released
+ * framebuffers are kept in LRU order, and the least recently released ones are
+ * freed whenever the released framebuffers exceed the memory budget. Since
+ * many released framebuffers are never reused, the budget is small, and
+ * framebuffers in use do not count towards it.
+ */
+class framebuffer_pool_t
+{
+  public:
+    static framebuffer_pool_t& get()
+    {
+        /* Delay instantiation until first call, at which point core should
+         * have been already initialized */
+        static framebuffer_pool_t pool;
+        return pool;
+    }
+
+    /**
+     * Get a complete framebuffer of the given size, either a released one or
+     * a newly created one.
+     */
+    bool acquire(int width, int height, const char *owner,
+        GLuint& fb, GLuint& tex)
+    {
+        auto it = std::find_if(idle.begin(), idle.end(), [&] (const buffer_t& b)
+        {
+            return b.width == width && b.height == height;
+        });
+
+        buffer_t buffer;
+        if (it != idle.end())
+        {
+            buffer = *it;
+            idle.erase(it);
+            idle_bytes -= buffer.bytes();
+            ++reused;
+        } else if (!create(width, height, buffer))
+        {
+            return false;
+        }
+
+        buffer.owner = owner;
+        in_use[buffer.fb] = buffer;
+        fb  = buffer.fb;
+        tex = buffer.tex;
+        return true;
+    }
+
+    /**
+     * Return the framebuffer to the pool.
+     *
+     * @return false if the framebuffer was not created by the pool.
+     */
+    bool release(GLuint fb)
+    {
+        auto it = in_use.find(fb);
+        if (it == in_use.end())
+        {
+            return false;
+        }
+
+        idle_bytes += it->second.bytes();
+        idle.push_front(it->second);
+        in_use.erase(it);
+        evict();
+        return true;
+    }
+
+    bool contains(GLuint fb) const
+    {
+        return in_use.count(fb);
+    }
+
+    void set_owner(GLuint fb, const char *owner)
+    {
+        auto it = in_use.find(fb);
+        if (it != in_use.end())
+        {
+            it->second.owner = owner;
+        }
+    }
+
+    wf::framebuffer_pool_stats_t get_stats() const
+    {
+        wf::framebuffer_pool_stats_t stats;
+        for (auto& [fb, buffer] : in_use)
+        {
+            auto& usage = stats.in_use[buffer.owner ?: "other"];
+            usage.count++;
+            usage.bytes += buffer.bytes();
+        }
+
+        stats.idle.count = idle.size();
+        stats.idle.bytes = idle_bytes;
+        stats.budget     = get_budget();
+        stats.created    = created;
+        stats.reused     = reused;
+        stats.evicted    = evicted;
+        return stats;
+    }
+
+  private:
+    struct buffer_t
+    {
+        GLuint fb  = -1;
+        GLuint tex = -1;
+        int width  = 0;
+        int height = 0;
+        const char *owner = nullptr;
+
+        size_t bytes() const
+        {
+            return 4ul * width * height;
+        }
+    };
+
+    std::map<GLuint, buffer_t> in_use;
+    /* Most recently released first */
+    std::list<buffer_t> idle;
+    size_t idle_bytes = 0;
+    uint64_t created  = 0;
+    uint64_t reused   = 0;
+    uint64_t evicted  = 0;
+
+    wf::option_wrapper_t<int> budget_mb{"core/framebuffer_pool_budget"};
+
+    size_t get_budget() const
+    {
+        return std::max(0, (int)budget_mb) * 1024ul * 1024ul;
+    }
+
+    bool create(int width, int height, buffer_t& buffer)
+    {
+        buffer.width  = width;
+        buffer.height = height;
+        GL_CALL(glGenFramebuffers(1, &buffer.fb));
+        GL_CALL(glGenTextures(1, &buffer.tex));
+        GL_CALL(glBindTexture(GL_TEXTURE_2D, buffer.tex));
+        GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
+        GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
+        GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
+        GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
+        GL_CALL(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height,
+            0, GL_RGBA, GL_UNSIGNED_BYTE, 0));
+
+        GL_CALL(glBindFramebuffer(GL_FRAMEBUFFER, buffer.fb));
+        GL_CALL(glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
+            GL_TEXTURE_2D, buffer.tex, 0));
+
+        auto status = GL_CALL(glCheckFramebufferStatus(GL_FRAMEBUFFER));
+        if (status != GL_FRAMEBUFFER_COMPLETE)
+        {
+            LOGE("Failed to initialize framebuffer: ",
+                framebuffer_status_to_str(status));
+            destroy(buffer);
+            return false;
+        }
+
+        ++created;
+        return true;
+    }
+
+    void destroy(const buffer_t& buffer)
+    {
+        OpenGL::invalidate_state_cache();
+        GL_CALL(glDeleteFramebuffers(1, &buffer.fb));
+        GL_CALL(glDeleteTextures(1, &buffer.tex));
+    }
+
+    void evict()
+    {
+        const size_t budget = get_budget();
+        while (!idle.empty() && (idle_bytes > budget))
+        {
+            destroy(idle.back());
+            idle_bytes -= idle.back().bytes();
+            idle.pop_back();
+            ++evicted;
+        }
+    }
+};
+}
+
+/* Allocate a framebuffer whose texture or framebuffer object were created
+ * outside of allocate(), as before the framebuffer pool. */
+static bool allocate_unpooled(wf::framebuffer_t& buffer, int width, int height)
 {
     bool first_allocate = false;
-    if (fb == (uint32_t)-1)
+    if (buffer.fb == (uint32_t)-1)
     {
         first_allocate = true;
-        GL_CALL(glGenFramebuffers(1, &fb));
+        GL_CALL(glGenFramebuffers(1, &buffer.fb));
     }
 
-    if (tex == (uint32_t)-1)
+    if (buffer.tex == (uint32_t)-1)
     {
         first_allocate = true;
-        GL_CALL(glGenTextures(1, &tex));
-        GL_CALL(glBindTexture(GL_TEXTURE_2D, tex));
+        GL_CALL(glGenTextures(1, &buffer.tex));
+        GL_CALL(glBindTexture(GL_TEXTURE_2D, buffer.tex));
         GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
         GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
         GL_CALL(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR));
@@ -346,15 +695,15 @@ bool wf::framebuffer_t::allocate(int width, int height)
     }
 
     bool is_resize = false;
-    /* Special case: fb = 0. This occurs in the default workspace streams, we don't
-     * resize anything */
-    if (fb != OpenGL::current_output_fb)
+    /* Special case: fb = 0. This occurs in the default workspace streams, we
+     * don't resize anything */
+    if (buffer.fb != OpenGL::current_output_fb)
     {
-        if (first_allocate || (width != viewport_width) ||
-            (height != viewport_height))
+        if (first_allocate || (width != buffer.viewport_width) ||
+            (height != buffer.viewport_height))
         {
             is_resize = true;
-            GL_CALL(glBindTexture(GL_TEXTURE_2D, tex));
+            GL_CALL(glBindTexture(GL_TEXTURE_2D, buffer.tex));
             GL_CALL(glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height,
                 0, GL_RGBA, GL_UNSIGNED_BYTE, 0));
         }
@@ -362,10 +711,10 @@ bool wf::framebuffer_t::allocate(int width, int height)
 
     if (first_allocate)
     {
-        GL_CALL(glBindFramebuffer(GL_FRAMEBUFFER, fb));
-        GL_CALL(glBindTexture(GL_TEXTURE_2D, tex));
+        GL_CALL(glBindFramebuffer(GL_FRAMEBUFFER, buffer.fb));
+        GL_CALL(glBindTexture(GL_TEXTURE_2D, buffer.tex));
         GL_CALL(glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0,
-            GL_TEXTURE_2D, tex, 0));
+            GL_TEXTURE_2D, buffer.tex, 0));
 
         auto status = GL_CALL(glCheckFramebufferStatus(GL_FRAMEBUFFER));
         if (status != GL_FRAMEBUFFER_COMPLETE)
@@ -377,13 +726,62 @@ bool wf::framebuffer_t::allocate(int width, int height)
         }
     }
 
+    buffer.viewport_width  = width;
+    buffer.viewport_height = height;
+
+    GL_CALL(glBindTexture(GL_TEXTURE_2D, 0));
+    GL_CALL(glBindFramebuffer(GL_FRAMEBUFFER, OpenGL::current_output_fb));
+
+    return is_resize || first_allocate;
+}
+
+wf::framebuffer_pool_stats_t OpenGL::get_framebuffer_pool_stats()
+{
+    return framebuffer_pool_t::get().get_stats();
+}
+
+bool wf::framebuffer_t::allocate(int width, int height)
+{
+    // Textures are bound and possibly deleted below
+    OpenGL::invalidate_state_cache();
+
+    auto& pool = framebuffer_pool_t::get();
+    const bool pooled = pool.contains(fb);
+    if (!pooled && ((fb != (uint32_t)-1) || (tex != (uint32_t)-1)))
+    {
+        // The framebuffer or the texture were set up outside of allocate()
+        return allocate_unpooled(*this, width, height);
+    }
+
+    bool changed = false;
+    if (pooled && (width == viewport_width) && (height == viewport_height))
+    {
+        pool.set_owner(fb, owner);
+    } else
+    {
+        // Trade the current buffer (if any) for one of the new size. The
+        // contents are invalidated either way.
+        if (pooled)
+        {
+            pool.release(fb);
+            reset();
+        }
+
+        changed = true;
+        if (!pool.acquire(width, height, owner, fb, tex))
+        {
+            GL_CALL(glBindFramebuffer(GL_FRAMEBUFFER, OpenGL::current_output_fb));
+            return false;
+        }
+    }
+
     viewport_width  = width;
     viewport_height = height;
 
     GL_CALL(glBindTexture(GL_TEXTURE_2D, 0));
     GL_CALL(glBindFramebuffer(GL_FRAMEBUFFER, OpenGL::current_output_fb));
 
-    return is_resize || first_allocate;
+    return changed;
 }
 
 void wf::framebuffer_t::bind() const
@@ -401,6 +799,13 @@ void wf::framebuffer_t::scissor(wlr_box box) const
 
 void wf::framebuffer_t::release()
 {
+    OpenGL::invalidate_state_cache();
+    if (framebuffer_pool_t::get().release(fb))
+    {
+        reset();
+        return;
+    }
+
     if ((fb != uint32_t(-1)) && (fb != 0))
     {
         GL_CALL(glDeleteFramebuffers(1, &fb));
@@ -558,6 +963,28 @@ wf::texture_t::texture_t(wlr_surface *surface) :
 
 namespace OpenGL
 {
+/**
+ * The GL state set by program_t, used to skip redundant GL calls.
+ * Texture state refers to texture unit 0.
+ */
+struct gl_state_cache_t
+{
+    bool valid     = false;
+    GLuint program = 0;
+    GLenum texture_target = 0;
+    GLuint texture = 0;
+};
+
+static gl_state_cache_t state_cache;
+
+void invalidate_state_cache()
+{
+    state_cache.valid = false;
+}
+
+static GLuint compile_variant(const std::string& vertex_source,
+    const std::string& fragment_source, wf::texture_type_t type);
+
 class program_t::impl
 {
   public:
@@ -567,37 +994,99 @@ class program_t::impl
     int active_program_idx = 0;
 
     int id[wf::TEXTURE_TYPE_ALL];
-    std::unordered_map<std::string, int> uniforms[wf::TEXTURE_TYPE_ALL];
 
-    /** Find the uniform location for the currently bound program */
-    int find_uniform_loc(const std::string& name)
+    /* The sources given to compile(). The program for each texture type is
+     * compiled from them when it is first used. */
+    std::string vertex_source, fragment_source;
+
+    void ensure_compiled(wf::texture_type_t type)
+    {
+        if ((id[type] == 0) && !fragment_source.empty())
+        {
+            id[type] = compile_variant(vertex_source, fragment_source, type);
+        }
+    }
+
+    /* Location which has not been queried yet */
+    static constexpr int UNRESOLVED = -2;
+
+    /* The name of a uniform or attribute, and its location in each program */
+    struct location_t
     {
-        auto it = uniforms[active_program_idx].find(name);
-        if (it != uniforms[active_program_idx].end())
+        std::string name;
+        int loc[wf::TEXTURE_TYPE_ALL];
+    };
+
+    std::vector<location_t> uniforms;
+    std::unordered_map<std::string, int> uniform_index;
+    std::vector<location_t> attribs;
+    std::unordered_map<std::string, int> attrib_index;
+
+    /* The builtin texture coordinate uniforms, and their last values in each
+     * program (base.xy, scale.xy). */
+    uniform_t uv_base, uv_scale;
+    glm::vec4 uv_values[wf::TEXTURE_TYPE_ALL];
+    bool uv_values_valid[wf::TEXTURE_TYPE_ALL] = {};
+
+    static int find_index(std::vector<location_t>& table,
+        std::unordered_map<std::string, int>& index, const std::string& name)
+    {
+        auto it = index.find(name);
+        if (it != index.end())
         {
             return it->second;
         }
 
-        uniforms[active_program_idx][name] =
-            GL_CALL(glGetUniformLocation(id[active_program_idx], name.c_str()));
+        location_t entry;
+        entry.name = name;
+        std::fill(std::begin(entry.loc), std::end(entry.loc), UNRESOLVED);
+        table.push_back(entry);
+        return index[name] = table.size() - 1;
+    }
 
-        return uniforms[active_program_idx][name];
+    /** Find the uniform location for the currently bound program */
+    int find_uniform_loc(uniform_t uniform)
+    {
+        if ((uniform.index == uv_base.index) || (uniform.index == uv_scale.index))
+        {
+            uv_values_valid[active_program_idx] = false;
+        }
+
+        int& loc = uniforms.at(uniform.index).loc[active_program_idx];
+        if (loc == UNRESOLVED)
+        {
+            loc = GL_CALL(glGetUniformLocation(id[active_program_idx],
+                uniforms[uniform.index].name.c_str()));
+        }
+
+        return loc;
     }
 
-    std::map<std::string, int> attribs[wf::TEXTURE_TYPE_ALL];
     /** Find the attrib location for the currently bound program */
-    int find_attrib_loc(const std::string& name)
+    int find_attrib_loc(attrib_t attrib)
     {
-        auto it = attribs[active_program_idx].find(name);
-        if (it != attribs[active_program_idx].end())
+        int& loc = attribs.at(attrib.index).loc[active_program_idx];
+        if (loc == UNRESOLVED)
         {
-            return it->second;
+            loc = GL_CALL(glGetAttribLocation(id[active_program_idx],
+                attribs[attrib.index].name.c_str()));
         }
 
-        attribs[active_program_idx][name] =
-            GL_CALL(glGetAttribLocation(id[active_program_idx], name.c_str()));
+        return loc;
+    }
+
+    /** Forget all locations and uniform values, after the programs change */
+    void reset_locations()
+    {
+        for (auto *table : {&uniforms, &attribs})
+        {
+            for (auto& entry : *table)
+            {
+                std::fill(std::begin(entry.loc), std::end(entry.loc), UNRESOLVED);
+            }
+        }
 
-        return attribs[active_program_idx][name];
+        std::fill(std::begin(uv_values_valid), std::end(uv_values_valid), false);
     }
 };
 
@@ -608,6 +1097,9 @@ program_t::program_t()
     {
         this->priv->id[i] = 0;
     }
+
+    priv->uv_base  = get_uniform("_wayfire_uv_base");
+    priv->uv_scale = get_uniform("_wayfire_uv_scale");
 }
 
 void program_t::set_simple(GLuint program_id, wf::texture_type_t type)
@@ -647,20 +1139,24 @@ std::map<wf::texture_type_t, texture_type_builtins> builtins = {
             builtin_ext_external_source}},
 };
 
+static GLuint compile_variant(const std::string& vertex_source,
+    const std::string& fragment_source, wf::texture_type_t type)
+{
+    const auto& type_builtins = builtins.at(type);
+    auto fragment = replace_builtin_with(fragment_source,
+        builtin, type_builtins.builtin);
+    fragment = replace_builtin_with(fragment,
+        builtin_ext, type_builtins.builtin_ext);
+
+    return compile_program(vertex_source, fragment);
+}
+
 void program_t::compile(const std::string& vertex_source,
     const std::string& fragment_source)
 {
     free_resources();
-
-    for (const auto& program_type : builtins)
-    {
-        auto fragment = replace_builtin_with(fragment_source,
-            builtin, program_type.second.builtin);
-        fragment = replace_builtin_with(fragment,
-            builtin_ext, program_type.second.builtin_ext);
-        this->priv->id[program_type.first] =
-            compile_program(vertex_source, fragment);
-    }
+    priv->vertex_source   = vertex_source;
+    priv->fragment_source = fragment_source;
 }
 
 void program_t::free_resources()
@@ -669,66 +1165,129 @@ void program_t::free_resources()
     {
         if (this->priv->id[i])
         {
+            if (state_cache.program == (GLuint)priv->id[i])
+            {
+                invalidate_state_cache();
+            }
+
             GL_CALL(glDeleteProgram(priv->id[i]));
             this->priv->id[i] = 0;
         }
     }
+
+    priv->vertex_source.clear();
+    priv->fragment_source.clear();
+    priv->reset_locations();
 }
 
 void program_t::use(wf::texture_type_t type)
 {
+    priv->ensure_compiled(type);
     if (priv->id[type] == 0)
     {
         throw std::runtime_error("program_t has no program for type " +
             std::to_string(type));
     }
 
-    GL_CALL(glUseProgram(priv->id[type]));
     priv->active_program_idx = type;
+    if (state_cache.valid && (state_cache.program == (GLuint)priv->id[type]))
+    {
+        return;
+    }
+
+    GL_CALL(glUseProgram(priv->id[type]));
+    if (!state_cache.valid)
+    {
+        state_cache = {};
+        state_cache.valid = true;
+    }
+
+    state_cache.program = priv->id[type];
 }
 
 int program_t::get_program_id(wf::texture_type_t type)
 {
+    priv->ensure_compiled(type);
     return priv->id[type];
 }
 
-void program_t::uniform1i(const std::string& name, int value)
+uniform_t program_t::get_uniform(const std::string& name)
 {
-    int loc = priv->find_uniform_loc(name);
+    return {impl::find_index(priv->uniforms, priv->uniform_index, name)};
+}
+
+attrib_t program_t::get_attrib(const std::string& name)
+{
+    return {impl::find_index(priv->attribs, priv->attrib_index, name)};
+}
+
+void program_t::uniform1i(uniform_t uniform, int value)
+{
+    int loc = priv->find_uniform_loc(uniform);
     GL_CALL(glUniform1i(loc, value));
 }
 
-void program_t::uniform1f(const std::string& name, float value)
+void program_t::uniform1f(uniform_t uniform, float value)
 {
-    int loc = priv->find_uniform_loc(name);
+    int loc = priv->find_uniform_loc(uniform);
     GL_CALL(glUniform1f(loc, value));
 }
 
-void program_t::uniform2f(const std::string& name, float x, float y)
+void program_t::uniform2f(uniform_t uniform, float x, float y)
 {
-    int loc = priv->find_uniform_loc(name);
+    int loc = priv->find_uniform_loc(uniform);
     GL_CALL(glUniform2f(loc, x, y));
 }
 
-void program_t::uniform3f(const std::string& name, float x, float y, float z)
+void program_t::uniform3f(uniform_t uniform, float x, float y, float z)
 {
-    int loc = priv->find_uniform_loc(name);
+    int loc = priv->find_uniform_loc(uniform);
     GL_CALL(glUniform3f(loc, x, y, z));
 }
 
-void program_t::uniform4f(const std::string& name, const glm::vec4& value)
+void program_t::uniform4f(uniform_t uniform, const glm::vec4& value)
 {
-    int loc = priv->find_uniform_loc(name);
+    int loc = priv->find_uniform_loc(uniform);
     GL_CALL(glUniform4f(loc, value.r, value.g, value.b, value.a));
 }
 
-void program_t::uniformMatrix4f(const std::string& name, const glm::mat4& value)
+void program_t::uniformMatrix4f(uniform_t uniform, const glm::mat4& value)
 {
-    int loc = priv->find_uniform_loc(name);
+    int loc = priv->find_uniform_loc(uniform);
     GL_CALL(glUniformMatrix4fv(loc, 1, GL_FALSE, &value[0][0]));
 }
 
-void program_t::attrib_pointer(const std::string& attrib,
+void program_t::uniform1i(const std::string& name, int value)
+{
+    uniform1i(get_uniform(name), value);
+}
+
+void program_t::uniform1f(const std::string& name, float value)
+{
+    uniform1f(get_uniform(name), value);
+}
+
+void program_t::uniform2f(const std::string& name, float x, float y)
+{
+    uniform2f(get_uniform(name), x, y);
+}
+
+void program_t::uniform3f(const std::string& name, float x, float y, float z)
+{
+    uniform3f(get_uniform(name), x, y, z);
+}
+
+void program_t::uniform4f(const std::string& name, const glm::vec4& value)
+{
+    uniform4f(get_uniform(name), value);
+}
+
+void program_t::uniformMatrix4f(const std::string& name, const glm::mat4& value)
+{
+    uniformMatrix4f(get_uniform(name), value);
+}
+
+void program_t::attrib_pointer(attrib_t attrib,
     int size, int stride, const void *ptr, GLenum type)
 {
     int loc = priv->find_attrib_loc(attrib);
@@ -738,18 +1297,37 @@ void program_t::attrib_pointer(const std::string& attrib,
     GL_CALL(glVertexAttribPointer(loc, size, type, GL_FALSE, stride, ptr));
 }
 
-void program_t::attrib_divisor(const std::string& attrib, int divisor)
+void program_t::attrib_divisor(attrib_t attrib, int divisor)
 {
     int loc = priv->find_attrib_loc(attrib);
     priv->active_attrs_divisors.insert(loc);
     GL_CALL(glVertexAttribDivisor(loc, divisor));
 }
 
+void program_t::attrib_pointer(const std::string& attrib,
+    int size, int stride, const void *ptr, GLenum type)
+{
+    attrib_pointer(get_attrib(attrib), size, stride, ptr, type);
+}
+
+void program_t::attrib_divisor(const std::string& attrib, int divisor)
+{
+    attrib_divisor(get_attrib(attrib), divisor);
+}
+
 void program_t::set_active_texture(const wf::texture_t& texture)
 {
-    GL_CALL(glActiveTexture(GL_TEXTURE0));
-    GL_CALL(glBindTexture(texture.target, texture.tex_id));
-    GL_CALL(glTexParameteri(texture.target, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
+    // The state cache is valid after use(), so it only needs to be checked
+    // for the texture.
+    if (!state_cache.valid || (state_cache.texture != texture.tex_id) ||
+        (state_cache.texture_target != texture.target))
+    {
+        GL_CALL(glActiveTexture(GL_TEXTURE0));
+        GL_CALL(glBindTexture(texture.target, texture.tex_id));
+        GL_CALL(glTexParameteri(texture.target, GL_TEXTURE_MIN_FILTER, GL_LINEAR));
+        state_cache.texture = texture.tex_id;
+        state_cache.texture_target = texture.target;
+    }
 
     glm::vec2 base{0.0f, 0.0f};
     glm::vec2 scale{1.0f, 1.0f};
@@ -768,8 +1346,17 @@ void program_t::set_active_texture(const wf::texture_t& texture)
         base.y   = 1.0 - base.y;
     }
 
-    uniform2f("_wayfire_uv_base", base.x, base.y);
-    uniform2f("_wayfire_uv_scale", scale.x, scale.y);
+    const glm::vec4 uv_values{base.x, base.y, scale.x, scale.y};
+    const int idx = priv->active_program_idx;
+    if (priv->uv_values_valid[idx] && (priv->uv_values[idx] == uv_values))
+    {
+        return;
+    }
+
+    uniform2f(priv->uv_base, base.x, base.y);
+    uniform2f(priv->uv_scale, scale.x, scale.y);
+    priv->uv_values[idx] = uv_values;
+    priv->uv_values_valid[idx] = true;
 }
 
 void program_t::deactivate()
@@ -786,6 +1373,5 @@ void program_t::deactivate()
 
     priv->active_attrs_divisors.clear();
     priv->active_attrs.clear();
-    GL_CALL(glUseProgram(0));
 }
 }
@@ -7,6 +7,104 @@ namespace wf
 namespace scene
 {
 struct root_node_t::priv_t
-{};
+{
+    /**
+     * The number of render instances which were (re)generated by incremental
+     * updates of render trees since the counter was last reset. Used for
+     * debugging.
+     */
+    size_t regenerated_instances = 0;
+
+    /**
+     * The number of render instances which were skipped during render passes
+     * since the counter was last reset, because their damage was empty (for
+     * example when they are occluded by opaque surfaces above them). Used for
+     * debugging.
+     */
+    size_t culled_instances = 0;
+
+    /**
+     * The number of boxes recorded by view_damage_raw(), and the number of
+     * views whose recorded damage was propagated through the scenegraph, since
+     * the counters were last reset. Used for debugging.
+     */
+    size_t recorded_damage_boxes = 0;
+    size_t flushed_damage_views  = 0;
+};
+
+/**
+ * Schedule the instructions of the given render instances, from the topmost
+ * to the bottommost. Instances subtract their opaque regions from @damage, so
+ * once it becomes empty, the remaining instances are fully occluded and are
+ * culled without visiting them.
+ */
+void schedule_instructions_culled(
+    const std::vector<render_instance_uptr>& instances,
+    std::vector<render_instruction_t>& instructions,
+    const wf::render_target_t& target, wf::region_t& damage);
+
+/**
+ * A helper for render instances of inner nodes.
+ *
+ * It keeps the render instances of the node's enabled children, grouped by
+ * child. When the scenegraph changes, only the groups of the children which
+ * are affected by the change are regenerated.
+ */
+class children_render_instances_t
+{
+  public:
+    /**
+     * A function which generates the render instances of the given child.
+     */
+    using generator_t =
+        std::function<void (node_t *child, std::vector<render_instance_uptr>&)>;
+
+    children_render_instances_t(node_t *self, generator_t generator);
+
+    /**
+     * Update the groups after the list of children of @changed changed.
+     * @changed may be the node itself or one of its (indirect) children.
+     * Changes outside of the node's subtree are ignored.
+     */
+    void update(node_t *changed);
+
+    /**
+     * Call @func for each render instance, from the topmost to the bottommost.
+     */
+    template<class Func>
+    void for_each(Func func)
+    {
+        for (auto& group : groups)
+        {
+            for (auto& instance : group.instances)
+            {
+                func(instance);
+            }
+        }
+    }
+
+    /**
+     * Schedule the instructions of all render instances, culling occluded
+     * instances like schedule_instructions_culled().
+     */
+    void schedule_instructions(std::vector<render_instruction_t>& instructions,
+        const wf::render_target_t& target, wf::region_t& damage);
+
+  private:
+    struct group_t
+    {
+        node_weak_ptr node;
+        std::vector<render_instance_uptr> instances;
+    };
+
+    node_t *self;
+    generator_t generator;
+    std::vector<group_t> groups;
+
+    // Synchronize the groups with the current list of enabled children,
+    // reusing the groups of the children which are still present.
+    void reconcile();
+    void generate(group_t& group, node_t *child);
+};
 }
 }
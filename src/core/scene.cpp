@@ -1,9 +1,11 @@
+#include <cmath>
 #include <limits>
 #include <memory>
 #include <wayfire/scene.hpp>
 #include <wayfire/view.hpp>
 #include <wayfire/output.hpp>
 #include <set>
+#include <unordered_map>
 #include <algorithm>
 
 #include "scene-priv.hpp"
@@ -44,6 +46,123 @@ bool keyboard_focus_node_t::operator <(const keyboard_focus_node_t& other) const
 
 namespace scene
 {
+/**
+ * A uniform grid over the bounding boxes of a node's children.
+ *
+ * Each cell contains the indices of the children which may accept input inside
+ * the cell, in stacking order. Children without bounded input are present in
+ * every cell.
+ */
+struct node_t::input_index_t
+{
+    // Nodes with fewer children are hit-tested with a linear search.
+    static constexpr size_t MIN_CHILDREN = 16;
+    static constexpr int MAX_GRID_SIZE   = 32;
+
+    bool dirty = true;
+    wf::geometry_t extents;
+    int grid_size = 1;
+    std::vector<std::vector<size_t>> cells;
+    std::vector<size_t> unbounded;
+
+    void rebuild(const std::vector<node_ptr>& children)
+    {
+        cells.clear();
+        unbounded.clear();
+
+        std::vector<wf::geometry_t> boxes(children.size());
+        int min_x = std::numeric_limits<int>::max();
+        int min_y = std::numeric_limits<int>::max();
+        int max_x = std::numeric_limits<int>::min();
+        int max_y = std::numeric_limits<int>::min();
+        for (size_t i = 0; i < children.size(); i++)
+        {
+            if (!children[i]->has_bounded_input())
+            {
+                unbounded.push_back(i);
+                continue;
+            }
+
+            boxes[i] = children[i]->get_cached_bounding_box();
+            min_x = std::min(min_x, boxes[i].x);
+            min_y = std::min(min_y, boxes[i].y);
+            max_x = std::max(max_x, boxes[i].x + boxes[i].width);
+            max_y = std::max(max_y, boxes[i].y + boxes[i].height);
+        }
+
+        dirty = false;
+        if ((min_x >= max_x) || (min_y >= max_y))
+        {
+            // No bounded children, only the unbounded list is used.
+            extents = {0, 0, 0, 0};
+            return;
+        }
+
+        extents   = {min_x, min_y, max_x - min_x, max_y - min_y};
+        grid_size = std::clamp((int)std::ceil(std::sqrt(children.size())),
+            1, MAX_GRID_SIZE);
+        cells.resize(grid_size * grid_size);
+
+        auto unbounded_it = unbounded.begin();
+        for (size_t i = 0; i < children.size(); i++)
+        {
+            if ((unbounded_it != unbounded.end()) && (*unbounded_it == i))
+            {
+                for (auto& cell : cells)
+                {
+                    cell.push_back(i);
+                }
+
+                ++unbounded_it;
+                continue;
+            }
+
+            const auto& box = boxes[i];
+            if ((box.width <= 0) || (box.height <= 0))
+            {
+                continue;
+            }
+
+            const int x1 = cell_x(box.x), x2 = cell_x(box.x + box.width - 1);
+            const int y1 = cell_y(box.y), y2 = cell_y(box.y + box.height - 1);
+            for (int y = y1; y <= y2; y++)
+            {
+                for (int x = x1; x <= x2; x++)
+                {
+                    cells[y * grid_size + x].push_back(i);
+                }
+            }
+        }
+    }
+
+    /**
+     * Get the indices of the children which may accept input at the given
+     * point, in stacking order.
+     */
+    const std::vector<size_t>& query(const wf::pointf_t& point) const
+    {
+        if (!(extents & point))
+        {
+            return unbounded;
+        }
+
+        return cells[cell_y(point.y) * grid_size + cell_x(point.x)];
+    }
+
+  private:
+    int cell_x(double x) const
+    {
+        return std::clamp((int)((x - extents.x) * grid_size / extents.width),
+            0, grid_size - 1);
+    }
+
+    int cell_y(double y) const
+    {
+        return std::clamp((int)((y - extents.y) * grid_size / extents.height),
+            0, grid_size - 1);
+    }
+};
+
 // ---------------------------------- node_t -----------------------------------
 node_t::~node_t()
 {}
@@ -51,6 +170,14 @@ node_t::~node_t()
 node_t::node_t(bool is_structure)
 {
     this->_is_structure = is_structure;
+
+    // Damage is emitted whenever the visible contents, and therefore the
+    // bounding box of a node change.
+    on_damage_invalidate_bbox = [=] (node_damage_signal*)
+    {
+        invalidate_bounding_box();
+    };
+    this->connect(&on_damage_invalidate_bbox);
 }
 
 void node_t::set_enabled(bool is_active)
@@ -69,18 +196,51 @@ std::string node_t::stringify_flags() const
     return "(" + fl + ")";
 }
 
+static std::optional<input_node_t> find_node_in_child(node_t *child,
+    const wf::pointf_t& local)
+{
+    if (!child->is_enabled())
+    {
+        return {};
+    }
+
+    if (child->has_bounded_input() && !(child->get_cached_bounding_box() & local))
+    {
+        return {};
+    }
+
+    return child->find_node_at(local);
+}
+
 std::optional<input_node_t> node_t::find_node_at(const wf::pointf_t& at)
 {
     auto local = this->to_local(at);
-    for (auto& node : get_children())
+    if (children.size() >= input_index_t::MIN_CHILDREN)
     {
-        if (!node->is_enabled())
+        if (!input_index)
         {
-            continue;
+            input_index = std::make_unique<input_index_t>();
         }
 
-        auto child_node = node->find_node_at(local);
-        if (child_node.has_value())
+        if (input_index->dirty)
+        {
+            input_index->rebuild(children);
+        }
+
+        for (size_t idx : input_index->query(local))
+        {
+            if (auto child_node = find_node_in_child(children[idx].get(), local))
+            {
+                return child_node;
+            }
+        }
+
+        return {};
+    }
+
+    for (auto& node : get_children())
+    {
+        if (auto child_node = find_node_in_child(node.get(), local))
         {
             return child_node;
         }
@@ -272,6 +432,203 @@ void node_t::gen_render_instances(std::vector<render_instance_uptr> & instances,
     }
 }
 
+// ------------------------ children_render_instances_t -----------------------
+children_render_instances_t::children_render_instances_t(node_t *self,
+    generator_t generator)
+{
+    this->self = self;
+    this->generator = std::move(generator);
+    reconcile();
+}
+
+void children_render_instances_t::generate(group_t& group, node_t *child)
+{
+    // Nested inner instances generate their children's groups while they are
+    // constructed, and count those themselves.
+    group.instances.clear();
+    generator(child, group.instances);
+    wf::get_core().scene()->priv->regenerated_instances += group.instances.size();
+}
+
+void children_render_instances_t::reconcile()
+{
+    std::unordered_map<node_t*, group_t*> existing;
+    for (auto& group : groups)
+    {
+        if (auto node = group.node.lock())
+        {
+            existing[node.get()] = &group;
+        }
+    }
+
+    std::vector<group_t> new_groups;
+    for (auto& ch : self->get_children())
+    {
+        if (!ch->is_enabled())
+        {
+            continue;
+        }
+
+        auto it = existing.find(ch.get());
+        if (it != existing.end())
+        {
+            new_groups.push_back(std::move(*it->second));
+        } else
+        {
+            new_groups.push_back(group_t{ch, {}});
+            generate(new_groups.back(), ch.get());
+        }
+    }
+
+    // Old groups which were not reused are destroyed here.
+    groups = std::move(new_groups);
+}
+
+void children_render_instances_t::update(node_t *changed)
+{
+    if (changed == self)
+    {
+        reconcile();
+        return;
+    }
+
+    // Find the child whose subtree contains the changed node.
+    node_t *child = changed;
+    while (child && (child->parent() != self))
+    {
+        child = child->parent();
+    }
+
+    if (!child)
+    {
+        return;
+    }
+
+    for (auto& group : groups)
+    {
+        if (group.node.lock().get() != child)
+        {
+            continue;
+        }
+
+        if ((group.instances.size() == 1) &&
+            group.instances.front()->update_instances(changed))
+        {
+            return;
+        }
+
+        generate(group, child);
+        return;
+    }
+}
+
+void children_render_instances_t::schedule_instructions(
+    std::vector<render_instruction_t>& instructions,
+    const wf::render_target_t& target, wf::region_t& damage)
+{
+    for (size_t i = 0; i < groups.size(); i++)
+    {
+        for (size_t j = 0; j < groups[i].instances.size(); j++)
+        {
+            if (damage.empty())
+            {
+                size_t culled = groups[i].instances.size() - j;
+                for (size_t k = i + 1; k < groups.size(); k++)
+                {
+                    culled += groups[k].instances.size();
+                }
+
+                wf::get_core().scene()->priv->culled_instances += culled;
+                return;
+            }
+
+            groups[i].instances[j]->schedule_instructions(instructions, target,
+                damage);
+        }
+    }
+}
+
+void schedule_instructions_culled(
+    const std::vector<render_instance_uptr>& instances,
+    std::vector<render_instruction_t>& instructions,
+    const wf::render_target_t& target, wf::region_t& damage)
+{
+    for (size_t i = 0; i < instances.size(); i++)
+    {
+        if (damage.empty())
+        {
+            wf::get_core().scene()->priv->culled_instances += instances.size() - i;
+            return;
+        }
+
+        instances[i]->schedule_instructions(instructions, target, damage);
+    }
+}
+
+/**
+ * A render instance for inner nodes which keeps its children's instances
+ * grouped, so that they can be updated incrementally.
+ */
+class inner_render_instance_t : public default_render_instance_t
+{
+    children_render_instances_t children;
+
+  public:
+    inner_render_instance_t(node_t *self, damage_callback callback,
+        children_render_instances_t::generator_t generator) :
+        default_render_instance_t(self, callback),
+        children(self, std::move(generator))
+    {}
+
+    void schedule_instructions(std::vector<render_instruction_t>& instructions,
+        const wf::render_target_t& target, wf::region_t& damage) override
+    {
+        children.schedule_instructions(instructions, target, damage);
+    }
+
+    void presentation_feedback(wf::output_t *output) override
+    {
+        children.for_each([&] (render_instance_uptr& ch)
+        {
+            ch->presentation_feedback(output);
+        });
+    }
+
+    direct_scanout try_scanout(wf::output_t *output) override
+    {
+        auto result = direct_scanout::SKIP;
+        children.for_each([&] (render_instance_uptr& ch)
+        {
+            if (result == direct_scanout::SKIP)
+            {
+                result = ch->try_scanout(output);
+            }
+        });
+
+        return result;
+    }
+
+    bool update_instances(node_t *node) override
+    {
+        children.update(node);
+        return true;
+    }
+};
+
+void floating_inner_node_t::gen_render_instances(
+    std::vector<render_instance_uptr> & instances, damage_callback push_damage,
+    wf::output_t *output)
+{
+    // Nested floating inner nodes (layers, workspace sets, ...) get their own
+    // inner instances, so a change regenerates only the instances of the
+    // changed child.
+    instances.push_back(std::make_unique<inner_render_instance_t>(this,
+        push_damage, [=] (node_t *child, auto& child_instances)
+    {
+        child->gen_render_instances(child_instances, push_damage, output);
+    }));
+}
+
 wf::geometry_t node_t::get_children_bounding_box()
 {
     if (children.empty())
@@ -302,6 +659,30 @@ wf::geometry_t node_t::get_bounding_box()
     return get_children_bounding_box();
 }
 
+wf::geometry_t node_t::get_cached_bounding_box()
+{
+    if (!cached_bounding_box)
+    {
+        cached_bounding_box = get_bounding_box();
+    }
+
+    return *cached_bounding_box;
+}
+
+void node_t::invalidate_bounding_box()
+{
+    // Ancestors have to be invalidated unconditionally: a node may have been
+    // recomputed after one of its children was invalidated.
+    for (node_t *node = this; node; node = node->parent())
+    {
+        node->cached_bounding_box.reset();
+        if (node->input_index)
+        {
+            node->input_index->dirty = true;
+        }
+    }
+}
+
 // ------------------------------ output_node_t --------------------------------
 // FIXME: output nodes are actually structure nodes, but we need to add and
 // remove them dynamically ...
@@ -341,29 +722,27 @@ class output_render_instance_t : public default_render_instance_t
 {
     wf::output_t *output;
     output_node_t *self;
-    std::vector<render_instance_uptr> children;
+
+    // Children are stored as a sublist, because we need to translate every
+    // time between global and output-local geometry.
+    children_render_instances_t children;
 
   public:
     output_render_instance_t(output_node_t *self, damage_callback callback,
         wf::output_t *output, wf::output_t *shown_on) :
-        default_render_instance_t(self, transform_damage(callback))
+        default_render_instance_t(self, transform_damage(callback, output)),
+        children(self, [=] (node_t *child, auto& instances)
+    {
+        child->gen_render_instances(instances,
+            transform_damage(callback, output), shown_on);
+    })
     {
         this->self   = self;
         this->output = output;
-
-        // Children are stored as a sublist, because we need to translate every
-        // time between global and output-local geometry.
-        for (auto& child : self->get_children())
-        {
-            if (child->is_enabled())
-            {
-                child->gen_render_instances(children,
-                    transform_damage(callback), shown_on);
-            }
-        }
     }
 
-    damage_callback transform_damage(damage_callback child_damage)
+    static damage_callback transform_damage(damage_callback child_damage,
+        wf::output_t *output)
     {
         return [=] (const wf::region_t& damage)
         {
@@ -404,11 +783,7 @@ class output_render_instance_t : public default_render_instance_t
         new_target.geometry.y -= offset.y;
 
         damage += -offset;
-        for (auto& ch : children)
-        {
-            ch->schedule_instructions(instructions, new_target, damage);
-        }
-
+        children.schedule_instructions(instructions, new_target, damage);
         damage += offset;
     }
 
@@ -421,16 +796,22 @@ class output_render_instance_t : public default_render_instance_t
             return direct_scanout::SKIP;
         }
 
-        for (auto& ch : children)
+        auto result = direct_scanout::SKIP;
+        children.for_each([&] (render_instance_uptr& ch)
         {
-            auto res = ch->try_scanout(scanout);
-            if (res != direct_scanout::SKIP)
+            if (result == direct_scanout::SKIP)
             {
-                return res;
+                result = ch->try_scanout(scanout);
             }
-        }
+        });
 
-        return direct_scanout::SKIP;
+        return result;
+    }
+
+    bool update_instances(node_t *node) override
+    {
+        children.update(node);
+        return true;
     }
 };
 
@@ -506,17 +887,18 @@ void update(node_ptr changed_node, uint32_t flags)
         flags |= update_flag::INPUT_STATE;
     }
 
-    if (changed_node == wf::get_core().scene())
+    node_t *root = changed_node.get();
+    while (root->parent())
     {
-        root_node_update_signal data;
-        data.flags = flags;
-        wf::get_core().scene()->emit(&data);
-        return;
+        root = root->parent();
     }
 
-    if (changed_node->parent())
+    if (root == wf::get_core().scene().get())
     {
-        update(changed_node->parent()->shared_from_this(), flags);
+        root_node_update_signal data;
+        data.flags = flags;
+        data.changed_node = changed_node.get();
+        wf::get_core().scene()->emit(&data);
     }
 }
 } // namespace scene
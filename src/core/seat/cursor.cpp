@@ -24,9 +24,12 @@ wf::cursor_t::cursor_t(wf::seat_t *seat)
     wlr_cursor_warp(cursor, NULL, cursor->x, cursor->y);
     init_xcursor();
 
-    config_reloaded.set_callback([=] (wf::signal_data_t*)
+    config_reloaded.set_callback([=] (wf::signal_data_t *data)
     {
-        init_xcursor();
+        if (wf::config_section_changed(data, "input"))
+        {
+            init_xcursor();
+        }
     });
 
     wf::get_core().connect_signal("reload-config", &config_reloaded);
@@ -153,8 +153,13 @@ wf::input_manager_t::input_manager_t()
     });
     input_device_created.connect(&wf::get_core().backend->events.new_input);
 
-    config_updated.set_callback([=] (wf::signal_data_t*)
+    config_updated.set_callback([=] (wf::signal_data_t *data)
     {
+        if (!wf::config_section_changed(data, "input"))
+        {
+            return;
+        }
+
         for (auto& dev : input_devices)
         {
             dev->update_options();
@@ -15,9 +15,12 @@
 
 void wf::keyboard_t::setup_listeners()
 {
-    on_config_reload.set_callback([&] (signal_data_t*)
+    on_config_reload.set_callback([&] (signal_data_t *data)
     {
-        reload_input_options();
+        if (config_section_changed(data, "input"))
+        {
+            reload_input_options();
+        }
     });
     wf::get_core().connect_signal("reload-config", &on_config_reload);
 
@@ -0,0 +1,209 @@
+#include <wayfire/util/log.hpp>
+#include "opengl-priv.hpp"
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <cstdlib>
+
+/*
+ * The shader cache stores linked program binaries, as returned by
+ * glGetProgramBinary(), in $XDG_CACHE_HOME/wayfire/shaders.
+ *
+ * Each file is named after a hash of the shader sources and the identity of
+ * the GL driver, so that a driver update or a change in the sources simply
+ * results in a different file. Files which the driver rejects are removed.
+ */
+namespace OpenGL
+{
+namespace
+{
+constexpr uint32_t SHADER_CACHE_MAGIC = 0x43534657; // "WFSC"
+/* Upper bound for the size of a program binary, to ignore corrupted files */
+constexpr uint32_t SHADER_CACHE_MAX_BINARY = 64 << 20;
+
+struct shader_cache_t
+{
+    bool initialized = false;
+    bool enabled     = false;
+    std::filesystem::path directory;
+    std::string driver;
+
+    int hits   = 0;
+    int misses = 0;
+
+    void init()
+    {
+        if (initialized)
+        {
+            return;
+        }
+
+        initialized = true;
+
+        GLint num_formats = 0;
+        GL_CALL(glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &num_formats));
+        if (num_formats <= 0)
+        {
+            LOGI("Shader cache disabled: the GL driver does not support program binaries");
+            return;
+        }
+
+        const char *cache_home = getenv("XDG_CACHE_HOME");
+        if (cache_home && *cache_home)
+        {
+            directory = cache_home;
+        } else if (const char *home = getenv("HOME"))
+        {
+            directory = std::filesystem::path(home) / ".cache";
+        } else
+        {
+            LOGI("Shader cache disabled: neither XDG_CACHE_HOME nor HOME is set");
+            return;
+        }
+
+        directory = directory / "wayfire" / "shaders";
+
+        std::error_code ec;
+        std::filesystem::create_directories(directory, ec);
+        if (ec)
+        {
+            LOGE("Shader cache disabled: cannot create ", directory.string(),
+                ": ", ec.message());
+            return;
+        }
+
+        for (GLenum name : {GL_VENDOR, GL_RENDERER, GL_VERSION})
+        {
+            auto str = (const char*)GL_CALL(glGetString(name));
+            driver += std::string(str ? str : "") + "\n";
+        }
+
+        enabled = true;
+    }
+
+    std::filesystem::path get_path(const std::string& vertex_source,
+        const std::string& frag_source)
+    {
+        // 64-bit FNV-1a
+        uint64_t hash = 0xcbf29ce484222325ull;
+        for (auto *str : {&driver, &vertex_source, &frag_source})
+        {
+            for (unsigned char c : *str)
+            {
+                hash = (hash ^ c) * 0x100000001b3ull;
+            }
+
+            hash = (hash ^ 0xff) * 0x100000001b3ull;
+        }
+
+        std::ostringstream name;
+        name << std::hex << std::setw(16) << std::setfill('0') << hash << ".bin";
+        return directory / name.str();
+    }
+
+    void log_stats(const char *event, const std::filesystem::path& path)
+    {
+        LOGD("Shader cache ", event, " for ", path.filename().string(),
+            " (", hits, " hits, ", misses, " misses)");
+    }
+};
+
+shader_cache_t cache;
+}
+
+GLuint load_program_binary(const std::string& vertex_source,
+    const std::string& frag_source)
+{
+    cache.init();
+    if (!cache.enabled)
+    {
+        return 0;
+    }
+
+    auto path = cache.get_path(vertex_source, frag_source);
+    std::ifstream file{path, std::ios::binary};
+
+    uint32_t header[3] = {0, 0, 0};
+    std::vector<char> binary;
+    if (file.read((char*)header, sizeof(header)) &&
+        (header[0] == SHADER_CACHE_MAGIC) && (header[2] <= SHADER_CACHE_MAX_BINARY))
+    {
+        binary.resize(header[2]);
+        file.read(binary.data(), binary.size());
+    }
+
+    if (!file || binary.empty())
+    {
+        ++cache.misses;
+        cache.log_stats("miss", path);
+        return 0;
+    }
+
+    GLuint program = GL_CALL(glCreateProgram());
+    GL_CALL(glProgramBinary(program, header[1], binary.data(), binary.size()));
+
+    GLint status = GL_FALSE;
+    GL_CALL(glGetProgramiv(program, GL_LINK_STATUS, &status));
+    if (status == GL_FALSE)
+    {
+        // Typically the driver changed in a way not visible in its identity
+        GL_CALL(glDeleteProgram(program));
+        std::error_code ec;
+        std::filesystem::remove(path, ec);
+
+        ++cache.misses;
+        cache.log_stats("miss (stale binary)", path);
+        return 0;
+    }
+
+    ++cache.hits;
+    cache.log_stats("hit", path);
+    return program;
+}
+
+void save_program_binary(GLuint program, const std::string& vertex_source,
+    const std::string& frag_source)
+{
+    cache.init();
+    if (!cache.enabled)
+    {
+        return;
+    }
+
+    GLint length = 0;
+    GL_CALL(glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length));
+    if (length <= 0)
+    {
+        return;
+    }
+
+    std::vector<char> binary(length);
+    GLenum format = 0;
+    GL_CALL(glGetProgramBinary(program, length, &length, &format, binary.data()));
+
+    auto path     = cache.get_path(vertex_source, frag_source);
+    auto tmp_path = path;
+    tmp_path += ".tmp";
+
+    uint32_t header[3] = {SHADER_CACHE_MAGIC, format, (uint32_t)length};
+    std::ofstream file{tmp_path, std::ios::binary | std::ios::trunc};
+    file.write((const char*)header, sizeof(header));
+    file.write(binary.data(), length);
+    file.close();
+
+    // Rename, so that concurrent instances never see a partial file
+    std::error_code ec;
+    if (file)
+    {
+        std::filesystem::rename(tmp_path, path, ec);
+    }
+
+    if (!file || ec)
+    {
+        LOGE("Failed to write shader cache file ", path.string());
+        std::filesystem::remove(tmp_path, ec);
+    }
+}
+}
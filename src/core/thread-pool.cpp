@@ -0,0 +1,326 @@
+#include <wayfire/thread-pool.hpp>
+#include <wayfire/core.hpp>
+#include <wayfire/config/option.hpp>
+#include <wayfire/util/log.hpp>
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace wf
+{
+class thread_pool_t::impl
+{
+  public:
+    struct queue_t
+    {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    int num_workers;
+    bool started = false;
+
+    std::vector<std::unique_ptr<queue_t>> queues;
+    std::vector<std::thread> workers;
+
+    /* Number of tasks in all queues */
+    std::atomic<int> queued{0};
+    /* Queue for the next task submitted from outside of the pool */
+    std::atomic<unsigned> next_queue{0};
+
+    std::mutex sleep_mutex;
+    std::condition_variable wakeup;
+    bool stopping = false;
+
+    /* The pool and queue index of the worker running on the current thread */
+    static thread_local impl *current_pool;
+    static thread_local int current_queue;
+
+    void start()
+    {
+        started = true;
+        for (int i = 0; i < num_workers; i++)
+        {
+            queues.push_back(std::make_unique<queue_t>());
+        }
+
+        for (int i = 0; i < num_workers; i++)
+        {
+            workers.emplace_back([this, i] { worker_main(i); });
+        }
+
+        LOGD("Started thread pool with ", num_workers, " workers");
+    }
+
+    void stop()
+    {
+        {
+            std::lock_guard<std::mutex> lock(sleep_mutex);
+            stopping = true;
+        }
+
+        wakeup.notify_all();
+        for (auto& worker : workers)
+        {
+            worker.join();
+        }
+    }
+
+    void push(std::function<void()> task)
+    {
+        int idx = (current_pool == this) ? current_queue : next_queue++ % queues.size();
+        {
+            std::lock_guard<std::mutex> lock(queues[idx]->mutex);
+            queues[idx]->tasks.push_back(std::move(task));
+        }
+
+        {
+            // Lock so that a worker cannot miss the update before sleeping
+            std::lock_guard<std::mutex> lock(sleep_mutex);
+            ++queued;
+        }
+
+        wakeup.notify_one();
+    }
+
+    /**
+     * Take a task, preferring the newest task of the own queue, so that a
+     * worker continues with the work it split, and otherwise the oldest task
+     * of another queue, which is usually the largest.
+     */
+    std::function<void()> pop()
+    {
+        std::function<void()> task;
+        if (queued == 0)
+        {
+            return task;
+        }
+
+        int own = (current_pool == this) ? current_queue : -1;
+        if (own >= 0)
+        {
+            std::lock_guard<std::mutex> lock(queues[own]->mutex);
+            if (!queues[own]->tasks.empty())
+            {
+                task = std::move(queues[own]->tasks.back());
+                queues[own]->tasks.pop_back();
+                --queued;
+                return task;
+            }
+        }
+
+        int start = std::max(own, 0);
+        for (size_t i = 0; i < queues.size(); i++)
+        {
+            auto& queue = queues[(start + i) % queues.size()];
+            std::lock_guard<std::mutex> lock(queue->mutex);
+            if (!queue->tasks.empty())
+            {
+                task = std::move(queue->tasks.front());
+                queue->tasks.pop_front();
+                --queued;
+                return task;
+            }
+        }
+
+        return task;
+    }
+
+    void worker_main(int idx)
+    {
+        current_pool  = this;
+        current_queue = idx;
+        while (true)
+        {
+            if (auto task = pop())
+            {
+                task();
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(sleep_mutex);
+            wakeup.wait(lock, [&] { return (queued > 0) || stopping; });
+            if (stopping && (queued == 0))
+            {
+                return;
+            }
+        }
+    }
+};
+
+thread_local thread_pool_t::impl *thread_pool_t::impl::current_pool = nullptr;
+thread_local int thread_pool_t::impl::current_queue = -1;
+
+static int get_default_num_workers()
+{
+    // One thread less than the number of cores, because the thread which
+    // waits for the tasks executes them as well.
+    int available = std::max(1, (int)std::thread::hardware_concurrency()) - 1;
+    int max_workers = 0;
+    auto option = std::dynamic_pointer_cast<wf::config::option_t<int>>(
+        wf::get_core().config.get_option("core/max_worker_threads"));
+    if (option)
+    {
+        max_workers = option->get_value();
+    }
+
+    return (max_workers > 0) ? std::min(max_workers, available) : available;
+}
+
+thread_pool_t& thread_pool_t::get()
+{
+    /* Delay instantiation until first call, at which point core should have
+     * been already initialized */
+    static thread_pool_t pool{get_default_num_workers()};
+    return pool;
+}
+
+thread_pool_t::thread_pool_t(int num_workers)
+{
+    priv = std::make_unique<impl>();
+    priv->num_workers = std::max(num_workers, 0);
+}
+
+thread_pool_t::~thread_pool_t()
+{
+    if (priv->started)
+    {
+        priv->stop();
+    }
+}
+
+int thread_pool_t::get_concurrency()
+{
+    return priv->num_workers + 1;
+}
+
+void thread_pool_t::submit(std::function<void()> task)
+{
+    if (priv->num_workers == 0)
+    {
+        task();
+        return;
+    }
+
+    if (!priv->started)
+    {
+        priv->start();
+    }
+
+    priv->push(std::move(task));
+}
+
+bool thread_pool_t::run_pending_task()
+{
+    if (!priv->started)
+    {
+        return false;
+    }
+
+    if (auto task = priv->pop())
+    {
+        task();
+        return true;
+    }
+
+    return false;
+}
+
+thread_pool_t::task_group_t::task_group_t(thread_pool_t& pool) : pool(pool)
+{}
+
+thread_pool_t::task_group_t::~task_group_t()
+{
+    wait_for_tasks();
+}
+
+void thread_pool_t::task_group_t::run(std::function<void()> task)
+{
+    ++remaining;
+    pool.submit([this, task = std::move(task)]
+    {
+        std::exception_ptr task_error;
+        try {
+            task();
+        } catch (...)
+        {
+            task_error = std::current_exception();
+        }
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (task_error && !error)
+        {
+            error = task_error;
+        }
+
+        if (--remaining == 0)
+        {
+            done.notify_all();
+        }
+    });
+}
+
+void thread_pool_t::task_group_t::wait_for_tasks()
+{
+    while (remaining > 0)
+    {
+        if (pool.run_pending_task())
+        {
+            continue;
+        }
+
+        // Nothing left to help with, the last tasks are running on other
+        // threads.
+        std::unique_lock<std::mutex> lock(mutex);
+        done.wait(lock, [&] { return remaining == 0; });
+    }
+
+    // The last task may still hold the mutex after decrementing the counter
+    std::lock_guard<std::mutex> lock(mutex);
+}
+
+void thread_pool_t::task_group_t::wait()
+{
+    wait_for_tasks();
+    if (error)
+    {
+        std::rethrow_exception(std::exchange(error, nullptr));
+    }
+}
+
+void thread_pool_t::parallel_for(int begin, int end,
+    const std::function<void(int, int)>& func, int grain_size)
+{
+    int count = end - begin;
+    if (count <= 0)
+    {
+        return;
+    }
+
+    // A few ranges per thread, so that threads which finish early can steal
+    grain_size = std::max(grain_size, 1);
+    int ranges = std::min((count + grain_size - 1) / grain_size, 4 * get_concurrency());
+    if (ranges <= 1)
+    {
+        func(begin, end);
+        return;
+    }
+
+    int range_size = (count + ranges - 1) / ranges;
+    task_group_t group{*this};
+    for (int start = begin + range_size; start < end; start += range_size)
+    {
+        int range_end = std::min(start + range_size, end);
+        group.run([&func, start, range_end] { func(start, range_end); });
+    }
+
+    func(begin, std::min(begin + range_size, end));
+    group.wait();
+}
+}
@@ -1,31 +1,245 @@
 #include <vector>
 #include "wayfire/debug.hpp"
 #include <string>
+#include <map>
+#include <set>
+#include <chrono>
+#include <fstream>
+#include <sstream>
 #include <wayfire/config/file.hpp>
+#include <wayfire/config/compound-option.hpp>
 #include <wayfire/config-backend.hpp>
 #include <wayfire/plugin.hpp>
 #include <wayfire/core.hpp>
+#include <wayfire/util.hpp>
+#include <wayfire/signal-definitions.hpp>
 
 #include <sys/inotify.h>
 #include <unistd.h>
 
 #define INOT_BUF_SIZE (sizeof(inotify_event) + NAME_MAX + 1)
 
+/* Editors and config tools often write the file in several steps, so changes
+ * are applied only once the file has not been modified for this long. */
+#define RELOAD_DEBOUNCE_MS 100
+
 static std::string config_dir, config_file;
 wf::config::config_manager_t *cfg_manager;
 
 static int wd_cfg_file;
 
+/* The text of each section of the config file, as it was last loaded */
+using section_sources_t = std::map<std::string, std::string>;
+static section_sources_t loaded_sections;
+
+/* Never destroyed, because the event loop may already be gone at exit */
+static wf::wl_timer *reload_timer;
+
 static void readd_watch(int fd)
 {
     inotify_add_watch(fd, config_dir.c_str(), IN_CREATE);
     wd_cfg_file = inotify_add_watch(fd, config_file.c_str(), IN_MODIFY);
 }
 
-static void reload_config(int fd)
+/**
+ * Split the contents of an ini file into the text of each section, including
+ * the section header. Text before the first section is ignored.
+ */
+static section_sources_t split_sections(const std::string& source)
 {
-    wf::config::load_configuration_options_from_file(*cfg_manager, config_file);
-    readd_watch(fd);
+    section_sources_t sections;
+    std::string *current = nullptr;
+
+    std::istringstream stream{source};
+    std::string line;
+    while (std::getline(stream, line))
+    {
+        auto first = line.find_first_not_of(" \t");
+        auto last  = line.find_last_not_of(" \t\r");
+        if ((first != std::string::npos) && (line[first] == '[') && (line[last] == ']'))
+        {
+            current = &sections[line.substr(first + 1, last - first - 1)];
+        }
+
+        if (current)
+        {
+            *current += line + "\n";
+        }
+    }
+
+    return sections;
+}
+
+static bool read_sections(section_sources_t& sections)
+{
+    std::ifstream file{config_file};
+    if (!file)
+    {
+        return false;
+    }
+
+    std::stringstream source;
+    source << file.rdbuf();
+    sections = split_sections(source.str());
+    return true;
+}
+
+/**
+ * Copy the values of the options in @updated to the options with the same
+ * names in @section. Only the options whose values differ are set, so only
+ * their callbacks are called.
+ *
+ * @return The number of options which changed.
+ */
+static int apply_section(wf::config::section_t& section,
+    wf::config::section_t& updated)
+{
+    int changed = 0;
+    for (auto& option : updated.get_registered_options())
+    {
+        auto existing = section.get_option_or(option->get_name());
+        if (!existing)
+        {
+            section.register_new_option(option);
+            ++changed;
+            continue;
+        }
+
+        auto compound = std::dynamic_pointer_cast<wf::config::compound_option_t>(existing);
+        if (compound)
+        {
+            auto updated_compound =
+                std::dynamic_pointer_cast<wf::config::compound_option_t>(option);
+            if (updated_compound &&
+                (compound->get_value_untyped() != updated_compound->get_value_untyped()))
+            {
+                compound->set_value_untyped(updated_compound->get_value_untyped());
+                ++changed;
+            }
+
+            continue;
+        }
+
+        if (existing->get_value_str() != option->get_value_str())
+        {
+            existing->set_value_str(option->get_value_str());
+            ++changed;
+        }
+    }
+
+    return changed;
+}
+
+/**
+ * Reload only the sections whose text changed since the last reload.
+ *
+ * The changed sections are parsed into copies of the current sections, so
+ * that options which were removed from the file are reset to their default
+ * values, and the results are then applied to the real options.
+ */
+static void reload_changed_sections()
+{
+    auto start = std::chrono::steady_clock::now();
+
+    section_sources_t sections;
+    if (!read_sections(sections))
+    {
+        LOGE("Failed to read config file ", config_file);
+        return;
+    }
+
+    std::set<std::string> changed;
+    for (auto& [name, text] : sections)
+    {
+        auto it = loaded_sections.find(name);
+        if ((it == loaded_sections.end()) || (it->second != text))
+        {
+            changed.insert(name);
+        }
+    }
+
+    for (auto& [name, text] : loaded_sections)
+    {
+        if (!sections.count(name))
+        {
+            changed.insert(name);
+        }
+    }
+
+    loaded_sections = std::move(sections);
+    if (changed.empty())
+    {
+        LOGD("Config file was written, but no section changed");
+        return;
+    }
+
+    wf::config::config_manager_t scratch;
+    std::string changed_source;
+    for (auto& name : changed)
+    {
+        if (auto section = cfg_manager->get_section(name))
+        {
+            scratch.merge_section(section->clone_with_name(name));
+        }
+
+        // New sections of an object type are created from the type's section
+        auto type_end = name.find(':');
+        if (type_end != std::string::npos)
+        {
+            auto type_name = name.substr(0, type_end);
+            auto type_section = cfg_manager->get_section(type_name);
+            if (type_section && !scratch.get_section(type_name))
+            {
+                scratch.merge_section(type_section->clone_with_name(type_name));
+            }
+        }
+
+        if (loaded_sections.count(name))
+        {
+            changed_source += loaded_sections[name];
+        }
+    }
+
+    wf::config::load_configuration_options_from_string(scratch, changed_source,
+        config_file);
+
+    wf::reload_config_signal data;
+    int changed_options = 0;
+    for (auto& name : changed)
+    {
+        auto updated = scratch.get_section(name);
+        if (!updated)
+        {
+            continue;
+        }
+
+        auto section = cfg_manager->get_section(name);
+        int count;
+        if (section)
+        {
+            count = apply_section(*section, *updated);
+        } else
+        {
+            cfg_manager->merge_section(updated);
+            count = updated->get_registered_options().size();
+        }
+
+        if (count > 0)
+        {
+            data.changed_sections.insert(name);
+            changed_options += count;
+        }
+    }
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now() - start);
+    LOGD("Reloaded ", changed.size(), " config sections in ",
+        elapsed.count() / 1000.0, "ms, ", changed_options, " options changed");
+
+    if (!data.changed_sections.empty())
+    {
+        wf::get_core().emit_signal("reload-config", &data);
+    }
 }
 
 static int handle_config_updated(int fd, uint32_t mask, void *data)
@@ -69,15 +283,20 @@ static int handle_config_updated(int fd, uint32_t mask, void *data)
 
     if (should_reload)
     {
-        LOGD("Reloading configuration file");
+        if (!reload_timer)
+        {
+            reload_timer = new wf::wl_timer;
+        }
 
-        reload_config(fd);
-        wf::get_core().emit_signal("reload-config", nullptr);
-    } else
-    {
-        readd_watch(fd);
+        reload_timer->set_timeout(RELOAD_DEBOUNCE_MS, [] ()
+        {
+            reload_changed_sections();
+            return false;
+        });
     }
 
+    readd_watch(fd);
+
     return 0;
 }
 
@@ -100,8 +319,10 @@ class dynamic_ini_config_t : public wf::config_backend_t
         config = wf::config::build_configuration(
             get_xml_dirs(), SYSCONFDIR "/wayfire/defaults.ini", config_file);
 
+        // build_configuration() has already loaded the config file
         int inotify_fd = inotify_init1(IN_CLOEXEC);
-        reload_config(inotify_fd);
+        read_sections(loaded_sections);
+        readd_watch(inotify_fd);
 
         wl_event_loop_add_fd(wl_display_get_event_loop(display),
             inotify_fd, WL_EVENT_READABLE, handle_config_updated, NULL);
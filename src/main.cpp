@@ -6,6 +6,8 @@
 #include <map>
 #include <fcntl.h>
 #include <filesystem>
+#include <chrono>
+#include <sstream>
 
 #include <unistd.h>
 #include <wayfire/debug.hpp>
@@ -43,6 +45,37 @@ static void print_help()
     exit(0);
 }
 
+/**
+ * Measures the duration of the phases of startup, so that the time it takes
+ * until the compositor is usable can be investigated.
+ */
+struct startup_timer_t
+{
+    using clock = std::chrono::steady_clock;
+    clock::time_point start = clock::now();
+    clock::time_point phase_start = start;
+    std::ostringstream phases;
+
+    static double to_ms(clock::duration duration)
+    {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+            duration).count() / 1000.0;
+    }
+
+    void end_phase(const char *name)
+    {
+        auto now = clock::now();
+        phases << " " << name << ": " << to_ms(now - phase_start) << "ms";
+        phase_start = now;
+    }
+
+    void log()
+    {
+        LOGI("Startup took ", to_ms(clock::now() - start), "ms.", phases.str(),
+            " (plugins: ", to_ms(plugin_manager::total_load_time), "ms)");
+    }
+};
+
 static bool drop_permissions(void)
 {
     if ((getuid() != geteuid()) || (getgid() != getegid()))
@@ -204,6 +237,11 @@ void parse_extended_debugging(const std::vector<std::string>& categories)
             LOGD("Enabling extended debugging for direct scanout");
             wf::log::enabled_categories.set(
                 (size_t)wf::log::logging_category::SCANOUT, 1);
+        } else if (cat == "render")
+        {
+            LOGD("Enabling extended debugging for rendering");
+            wf::log::enabled_categories.set(
+                (size_t)wf::log::logging_category::RENDER, 1);
         } else
         {
             LOGE("Unrecognized debugging category \"", cat, "\"");
@@ -304,6 +342,7 @@ int main(int argc, char *argv[])
     LOGI("Starting wayfire version ", WAYFIRE_VERSION);
     /* First create display and initialize safe-list's event loop, so that
      * wf objects (which depend on safe-list) can work */
+    startup_timer_t startup_timer;
     auto display = wl_display_create();
     auto& core   = wf::get_core_impl();
 
@@ -340,6 +379,7 @@ int main(int argc, char *argv[])
     core.egl = wlr_gles2_renderer_get_egl(core.renderer);
     assert(core.egl);
 
+    startup_timer.end_phase("renderer");
     if (!drop_permissions())
     {
         wl_display_destroy_clients(core.display);
@@ -360,7 +400,9 @@ int main(int argc, char *argv[])
     LOGD("Using configuration backend: ", config_backend);
     core.config_backend = std::unique_ptr<wf::config_backend_t>(backend);
     core.config_backend->init(display, core.config, config_file);
+    startup_timer.end_phase("config");
     core.init();
+    startup_timer.end_phase("core");
 
     auto socket = choose_socket(core.display);
     if (!socket)
@@ -381,8 +423,11 @@ int main(int argc, char *argv[])
         return -1;
     }
 
+    startup_timer.end_phase("outputs");
     setenv("WAYLAND_DISPLAY", core.wayland_display.c_str(), 1);
     core.post_init();
+    startup_timer.end_phase("post-init");
+    startup_timer.log();
 
     wl_display_run(core.display);
 
@@ -0,0 +1,381 @@
+#include "frame-timing.hpp"
+#include "wayfire/debug.hpp"
+#include <wayfire/opengl.hpp>
+#include <wayfire/util/log.hpp>
+
+#include <GLES2/gl2ext.h>
+#include <EGL/egl.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+const char*wf::frame_phase_to_string(frame_phase_t phase)
+{
+    switch (phase)
+    {
+      case FRAME_PHASE_EFFECTS:
+        return "effects";
+
+      case FRAME_PHASE_SCANOUT:
+        return "scanout";
+
+      case FRAME_PHASE_MAKE_CURRENT:
+        return "make-current";
+
+      case FRAME_PHASE_RENDER:
+        return "render";
+
+      case FRAME_PHASE_OVERLAY:
+        return "overlay";
+
+      case FRAME_PHASE_POSTPROCESS:
+        return "postprocess";
+
+      case FRAME_PHASE_CURSORS:
+        return "cursors";
+
+      case FRAME_PHASE_SWAP:
+        return "swap";
+
+      case FRAME_PHASE_POST_EFFECTS:
+        return "post-effects";
+
+      case FRAME_PHASE_TOTAL:
+        break;
+    }
+
+    return "unknown";
+}
+
+void wf::frame_timing_histogram_t::add(int64_t duration_ns)
+{
+    int bucket = 0;
+    for (int64_t usec = duration_ns / 1000; usec > 1; usec >>= 1)
+    {
+        ++bucket;
+    }
+
+    buckets[std::min(bucket, BUCKETS - 1)]++;
+    count++;
+    total_ns += duration_ns;
+    max_ns    = std::max(max_ns, duration_ns);
+}
+
+namespace wf
+{
+/**
+ * A small pool of GL_EXT_disjoint_timer_query objects. Results of queries
+ * are typically available one or two frames after they were issued.
+ */
+class frame_timing_recorder_t::gpu_timer_t
+{
+  public:
+    static constexpr int QUERIES = 4;
+
+    bool available = false;
+
+    gpu_timer_t()
+    {
+        const char *extensions = (const char*)glGetString(GL_EXTENSIONS);
+        if (!extensions || !strstr(extensions, "GL_EXT_disjoint_timer_query"))
+        {
+            LOGC(RENDER, "GPU timer queries are not supported, ",
+                "only CPU frame timings will be recorded");
+            return;
+        }
+
+        gen_queries = (PFNGLGENQUERIESEXTPROC)
+            eglGetProcAddress("glGenQueriesEXT");
+        delete_queries = (PFNGLDELETEQUERIESEXTPROC)
+            eglGetProcAddress("glDeleteQueriesEXT");
+        begin_query = (PFNGLBEGINQUERYEXTPROC)
+            eglGetProcAddress("glBeginQueryEXT");
+        end_query = (PFNGLENDQUERYEXTPROC)
+            eglGetProcAddress("glEndQueryEXT");
+        get_query_uiv = (PFNGLGETQUERYOBJECTUIVEXTPROC)
+            eglGetProcAddress("glGetQueryObjectuivEXT");
+        get_query_ui64v = (PFNGLGETQUERYOBJECTUI64VEXTPROC)
+            eglGetProcAddress("glGetQueryObjectui64vEXT");
+
+        if (!gen_queries || !delete_queries || !begin_query || !end_query ||
+            !get_query_uiv || !get_query_ui64v)
+        {
+            LOGE("GL_EXT_disjoint_timer_query is advertised, but not all of "
+                 "its functions could be loaded");
+            return;
+        }
+
+        for (auto& query : queries)
+        {
+            GL_CALL(gen_queries(1, &query.id));
+        }
+
+        available = true;
+    }
+
+    ~gpu_timer_t()
+    {
+        if (!available)
+        {
+            return;
+        }
+
+        OpenGL::render_begin();
+        for (auto& query : queries)
+        {
+            GL_CALL(delete_queries(1, &query.id));
+        }
+
+        OpenGL::render_end();
+    }
+
+    /**
+     * Collect the results of the finished queries.
+     * @param callback Called with the frame sequence number and the GPU time.
+     */
+    template<class Callback>
+    void collect(Callback callback)
+    {
+        GLint disjoint = 0;
+        GL_CALL(glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint));
+
+        for (auto& query : queries)
+        {
+            if (!query.pending)
+            {
+                continue;
+            }
+
+            GLuint ready = 0;
+            GL_CALL(get_query_uiv(query.id, GL_QUERY_RESULT_AVAILABLE_EXT, &ready));
+            if (!ready)
+            {
+                continue;
+            }
+
+            GLuint64 elapsed = 0;
+            GL_CALL(get_query_ui64v(query.id, GL_QUERY_RESULT_EXT, &elapsed));
+            query.pending = false;
+
+            // A disjoint operation (e.g. a GPU frequency change) makes the
+            // results of all queries in flight meaningless.
+            if (!disjoint)
+            {
+                callback(query.seq, (int64_t)elapsed);
+            }
+        }
+    }
+
+    void begin(uint64_t seq)
+    {
+        for (auto& query : queries)
+        {
+            if (!query.pending)
+            {
+                GL_CALL(begin_query(GL_TIME_ELAPSED_EXT, query.id));
+                query.seq = seq;
+                running   = &query;
+                return;
+            }
+        }
+
+        // All queries are still in flight, skip measuring this frame.
+    }
+
+    void end()
+    {
+        if (running)
+        {
+            GL_CALL(end_query(GL_TIME_ELAPSED_EXT));
+            running->pending = true;
+            running = nullptr;
+        }
+    }
+
+  private:
+    struct query_t
+    {
+        GLuint id     = 0;
+        uint64_t seq  = 0;
+        bool pending  = false;
+    };
+
+    std::array<query_t, QUERIES> queries;
+    query_t *running = nullptr;
+
+    PFNGLGENQUERIESEXTPROC gen_queries = nullptr;
+    PFNGLDELETEQUERIESEXTPROC delete_queries = nullptr;
+    PFNGLBEGINQUERYEXTPROC begin_query = nullptr;
+    PFNGLENDQUERYEXTPROC end_query     = nullptr;
+    PFNGLGETQUERYOBJECTUIVEXTPROC get_query_uiv     = nullptr;
+    PFNGLGETQUERYOBJECTUI64VEXTPROC get_query_ui64v = nullptr;
+};
+
+frame_timing_recorder_t::frame_timing_recorder_t()
+{
+    ring.resize(MAX_SAMPLES);
+}
+
+frame_timing_recorder_t::~frame_timing_recorder_t() = default;
+
+int64_t frame_timing_recorder_t::now()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void frame_timing_recorder_t::begin_frame()
+{
+    current     = {};
+    current.seq = next_seq;
+    current.start_ns = now();
+    current.phase_ns.fill(-1);
+}
+
+void frame_timing_recorder_t::begin_phase(frame_phase_t phase)
+{
+    phase_start = now();
+}
+
+void frame_timing_recorder_t::end_phase(frame_phase_t phase)
+{
+    current.phase_ns[phase] = now() - phase_start;
+}
+
+void frame_timing_recorder_t::end_frame(frame_result_t result)
+{
+    current.result   = result;
+    current.total_ns = now() - current.start_ns;
+
+    if (result == FRAME_RESULT_RENDERED)
+    {
+        for (int i = 0; i < FRAME_PHASE_TOTAL; i++)
+        {
+            if (current.phase_ns[i] >= 0)
+            {
+                phases[i].add(current.phase_ns[i]);
+            }
+        }
+
+        total.add(current.total_ns);
+    }
+
+    ring[next_seq % MAX_SAMPLES] = current;
+    ++next_seq;
+}
+
+void frame_timing_recorder_t::begin_gpu_timer()
+{
+    if (!gpu_timer)
+    {
+        gpu_timer = std::make_unique<gpu_timer_t>();
+    }
+
+    if (!gpu_timer->available)
+    {
+        return;
+    }
+
+    gpu_timer->collect([&] (uint64_t seq, int64_t elapsed)
+    {
+        if (auto sample = find_sample(seq))
+        {
+            sample->gpu_ns = elapsed;
+            gpu.add(elapsed);
+        }
+    });
+
+    gpu_timer->begin(current.seq);
+}
+
+void frame_timing_recorder_t::end_gpu_timer()
+{
+    if (gpu_timer && gpu_timer->available)
+    {
+        gpu_timer->end();
+    }
+}
+
+int frame_timing_recorder_t::register_hook(const std::string& owner,
+    const std::string& stage)
+{
+    auto it = hook_ids.find({owner, stage});
+    if (it != hook_ids.end())
+    {
+        return it->second;
+    }
+
+    hook_timing_t timing;
+    timing.owner = owner;
+    timing.stage = stage;
+    hooks.push_back(timing);
+    return hook_ids[{owner, stage}] = hooks.size() - 1;
+}
+
+void frame_timing_recorder_t::record_hook(int hook_id, int64_t duration_ns)
+{
+    auto& timing = hooks[hook_id];
+    timing.calls++;
+    timing.total_ns += duration_ns;
+    timing.max_ns    = std::max(timing.max_ns, duration_ns);
+}
+
+frame_timing_sample_t*frame_timing_recorder_t::find_sample(uint64_t seq)
+{
+    if ((seq < reset_seq) || (seq >= next_seq) || (next_seq - seq > MAX_SAMPLES))
+    {
+        return nullptr;
+    }
+
+    return &ring[seq % MAX_SAMPLES];
+}
+
+frame_timing_stats_t frame_timing_recorder_t::get_stats() const
+{
+    frame_timing_stats_t stats;
+
+    const uint64_t count = std::min<uint64_t>(next_seq - reset_seq, MAX_SAMPLES);
+    stats.samples.reserve(count);
+    for (uint64_t seq = next_seq - count; seq < next_seq; seq++)
+    {
+        stats.samples.push_back(ring[seq % MAX_SAMPLES]);
+    }
+
+    stats.phases = phases;
+    stats.total  = total;
+    stats.gpu    = gpu;
+    for (auto& timing : hooks)
+    {
+        if (timing.calls > 0)
+        {
+            stats.hooks.push_back(timing);
+        }
+    }
+
+    stats.gpu_timer_available = gpu_timer && gpu_timer->available;
+    return stats;
+}
+
+void frame_timing_recorder_t::reset()
+{
+    // Keep the sequence numbers so that pending GPU queries of dropped
+    // frames are ignored.
+    for (auto& sample : ring)
+    {
+        sample = {};
+    }
+
+    phases = {};
+    total  = {};
+    gpu    = {};
+    // Hook ids stay valid, only their timings are dropped
+    for (auto& timing : hooks)
+    {
+        timing.calls    = 0;
+        timing.total_ns = 0;
+        timing.max_ns   = 0;
+    }
+
+    reset_seq = next_seq;
+}
+}
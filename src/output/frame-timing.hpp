@@ -0,0 +1,75 @@
+#pragma once
+
+#include <wayfire/frame-timing.hpp>
+#include <map>
+#include <memory>
+
+namespace wf
+{
+/**
+ * Records the timings of the repaint cycles of an output in a ring buffer of
+ * the last MAX_SAMPLES frames, and accumulates them in histograms.
+ *
+ * CPU times are measured with the steady clock. If the renderer supports
+ * GL_EXT_disjoint_timer_query, the GPU time of the rendering phases is
+ * measured too. Timer queries are asynchronous, so their results are
+ * collected a few frames later and written back into the ring buffer.
+ */
+class frame_timing_recorder_t
+{
+  public:
+    static constexpr size_t MAX_SAMPLES = 256;
+
+    frame_timing_recorder_t();
+    ~frame_timing_recorder_t();
+
+    /** @return The current time of the steady clock, in nanoseconds. */
+    static int64_t now();
+
+    void begin_frame();
+    void begin_phase(frame_phase_t phase);
+    void end_phase(frame_phase_t phase);
+    void end_frame(frame_result_t result);
+
+    /**
+     * Start/stop measuring the GPU time of the frame. Must be called with
+     * the GL context current.
+     */
+    void begin_gpu_timer();
+    void end_gpu_timer();
+
+    /**
+     * Get the id under which the calls of @owner's hooks in @stage are
+     * recorded. Registering the same owner and stage again gives the same id.
+     */
+    int register_hook(const std::string& owner, const std::string& stage);
+
+    /** Account the time spent in a single call of a registered hook. */
+    void record_hook(int hook_id, int64_t duration_ns);
+
+    frame_timing_stats_t get_stats() const;
+    void reset();
+
+  private:
+    std::vector<frame_timing_sample_t> ring;
+    uint64_t next_seq = 0;
+    /* Frames before reset_seq were dropped by reset(). */
+    uint64_t reset_seq = 0;
+
+    frame_timing_sample_t current;
+    int64_t phase_start = 0;
+
+    std::array<frame_timing_histogram_t, FRAME_PHASE_TOTAL> phases;
+    frame_timing_histogram_t total;
+    frame_timing_histogram_t gpu;
+
+    /* Indexed by the ids from register_hook() */
+    std::vector<hook_timing_t> hooks;
+    std::map<std::pair<std::string, std::string>, int> hook_ids;
+
+    class gpu_timer_t;
+    std::unique_ptr<gpu_timer_t> gpu_timer;
+
+    frame_timing_sample_t *find_sample(uint64_t seq);
+};
+}
@@ -13,14 +13,23 @@
 #include <wayfire/util/log.hpp>
 
 
+std::chrono::steady_clock::duration plugin_manager::total_load_time{0};
+
 plugin_manager::plugin_manager(wf::output_t *o)
 {
     this->output = o;
     this->plugins_opt.load_option("core/plugins");
 
+    auto start = std::chrono::steady_clock::now();
     reload_dynamic_plugins();
     load_static_plugins();
 
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    total_load_time += elapsed;
+    LOGD("Loaded plugins for output ", o->to_string(), " in ",
+        std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count() / 1000.0,
+        "ms");
+
     this->plugins_opt.set_callback([=] ()
     {
         /* reload when config reload has finished */
@@ -3,6 +3,7 @@
 
 #include <vector>
 #include <unordered_map>
+#include <chrono>
 #include "wayfire/plugin.hpp"
 #include "config.h"
 #include "wayfire/util.hpp"
@@ -24,6 +25,9 @@ struct plugin_manager
     void reload_dynamic_plugins();
     wf::wl_idle_call idle_reaload_plugins;
 
+    /** The total time spent loading plugins for new outputs */
+    static std::chrono::steady_clock::duration total_load_time;
+
   private:
     wf::output_t *output;
     wf::option_wrapper_t<std::string> plugins_opt;
@@ -16,8 +16,12 @@
 #include "wayfire/workspace-manager.hpp"
 #include "../core/seat/seat.hpp"
 #include "../core/opengl-priv.hpp"
+#include "../core/scene-priv.hpp"
+#include "frame-timing.hpp"
 #include "../main.hpp"
 #include <algorithm>
+#include <map>
+#include <unordered_map>
 #include <wayfire/nonstd/reverse.hpp>
 #include <wayfire/nonstd/safe-list.hpp>
 #include <wayfire/util/log.hpp>
@@ -40,20 +44,39 @@ struct output_damage_t
     wlr_output_damage *damage_manager;
     output_t *wo;
 
-    void update_scenegraph()
+    /**
+     * Update the render instances after the list of children of @changed
+     * changed. If @changed is null, the whole render tree is regenerated.
+     */
+    void update_scenegraph(scene::node_t *changed = nullptr)
     {
         auto root = wf::get_core().scene();
+        root->priv->regenerated_instances = 0;
 
-        scene::damage_callback push_damage = [=] (wf::region_t region)
+        const bool up_to_date = changed && !render_instances.empty() &&
+            std::all_of(render_instances.begin(), render_instances.end(),
+                [&] (const scene::render_instance_uptr& instance)
         {
-            // Damage is pushed up to the root in root coordinate system,
-            // we need it in layout-local coordinate system.
-            region += -wf::origin(wo->get_layout_geometry());
-            this->damage(region);
-        };
+            return instance->update_instances(changed);
+        });
+
+        if (!up_to_date)
+        {
+            scene::damage_callback push_damage = [=] (wf::region_t region)
+            {
+                // Damage is pushed up to the root in root coordinate system,
+                // we need it in layout-local coordinate system.
+                region += -wf::origin(wo->get_layout_geometry());
+                this->damage(region);
+            };
+
+            render_instances.clear();
+            root->gen_render_instances(render_instances, push_damage, wo);
+        }
 
-        render_instances.clear();
-        root->gen_render_instances(render_instances, push_damage, wo);
+        LOGC(RENDER, "Output ", wo->to_string(), ": regenerated ",
+            root->priv->regenerated_instances, " render instances",
+            up_to_date ? "" : " (full rebuild)");
     }
 
     output_damage_t(output_t *output)
@@ -75,11 +98,42 @@ struct output_damage_t
                 return;
             }
 
-            update_scenegraph();
+            // When a node is enabled or disabled, the list of enabled
+            // children of its parent changes.
+            scene::node_t *changed = data->changed_node;
+            if ((data->flags & scene::update_flag::ENABLED) && changed->parent())
+            {
+                changed = changed->parent();
+            }
+
+            update_scenegraph(changed);
         };
 
         root->connect<scene::root_node_update_signal>(&root_update);
         update_scenegraph();
+
+        auto section =
+            wf::get_core().config_backend->get_output_section(output->handle);
+        merge_overhead.load_option(section->get_name() + "/damage_merge_overhead");
+        max_rects.load_option(section->get_name() + "/damage_max_rects");
+    }
+
+    wf::option_wrapper_t<double> merge_overhead;
+    wf::option_wrapper_t<int> max_rects;
+
+    /**
+     * Merge the rectangles of the frame damage, so that fewer scissored draws
+     * are needed to repaint it. Needs to be called after accumulate_damage().
+     */
+    void simplify_damage()
+    {
+        const int before = frame_damage.rect_count();
+        frame_damage.simplify(merge_overhead, max_rects);
+        if (runtime_config.damage_debug)
+        {
+            LOGI("Output ", wo->to_string(), ": damage simplified from ", before,
+                " to ", frame_damage.rect_count(), " rectangles");
+        }
     }
 
     /**
@@ -274,12 +328,31 @@ struct output_damage_t
  */
 struct effect_hook_manager_t
 {
-    using effect_container_t = wf::safe_list_t<effect_hook_t*>;
+    /* A hook, with its id in the frame timing statistics */
+    struct effect_t
+    {
+        effect_hook_t *hook;
+        int timing_id;
+    };
+
+    using effect_container_t = wf::safe_list_t<effect_t>;
     effect_container_t effects[OUTPUT_EFFECT_TOTAL];
 
-    void add_effect(effect_hook_t *hook, output_effect_type_t type)
+    frame_timing_recorder_t *timing;
+    effect_hook_manager_t(frame_timing_recorder_t *timing)
     {
-        effects[type].push_back(hook);
+        this->timing = timing;
+    }
+
+    void add_effect(effect_hook_t *hook, output_effect_type_t type,
+        const std::string& owner)
+    {
+        static const char *stages[OUTPUT_EFFECT_TOTAL] = {
+            "pre", "damage", "overlay", "post"
+        };
+
+        effects[type].push_back(effect_t{hook,
+            timing->register_hook(owner.empty() ? "unnamed" : owner, stages[type])});
     }
 
     bool can_scanout() const
@@ -292,33 +365,86 @@ struct effect_hook_manager_t
     {
         for (int i = 0; i < OUTPUT_EFFECT_TOTAL; i++)
         {
-            effects[i].remove_all(hook);
+            effects[i].remove_if([=] (const effect_t& effect)
+            {
+                return effect.hook == hook;
+            });
         }
     }
 
     void run_effects(output_effect_type_t type)
     {
-        effects[type].for_each([] (auto effect)
-        { (*effect)(); });
+        // The hook may remove itself, so the effect is copied.
+        effects[type].for_each([&] (effect_t effect)
+        {
+            const int64_t start = frame_timing_recorder_t::now();
+            (*effect.hook)();
+            timing->record_hook(effect.timing_id,
+                frame_timing_recorder_t::now() - start);
+        });
     }
 };
 
+static const char *fused_pixel_vertex_source =
+    R"(
+#version 100
+
+attribute mediump vec2 position;
+attribute highp vec2 uvPosition;
+
+varying highp vec2 uvpos;
+
+void main() {
+    gl_Position = vec4(position.xy, 0.0, 1.0);
+    uvpos = uvPosition;
+}
+)";
+
 /**
  * A class to manage and run postprocessing effects
  */
 struct postprocessing_manager_t
 {
-    using post_container_t = wf::safe_list_t<post_hook_t*>;
+    /* A post hook or a point-wise effect, with its id in the frame timing
+     * statistics */
+    struct post_effect_t
+    {
+        post_hook_t *hook = nullptr;
+        pixel_effect_t *pixel = nullptr;
+        int timing_id = -1;
+    };
+
+    using post_container_t = wf::safe_list_t<post_effect_t>;
     post_container_t post_effects;
+    std::unordered_map<void*, std::string> owners;
     wf::framebuffer_t post_buffers[3];
     /* Buffer to which other operations render to */
     static constexpr uint32_t default_out_buffer = 0;
 
+    /* A program for a run of consecutive point-wise effects, with the
+     * handles of the uniforms of each effect */
+    struct fused_program_t
+    {
+        OpenGL::program_t program;
+        std::vector<std::vector<OpenGL::uniform_t>> uniforms;
+    };
+
+    std::map<std::vector<pixel_effect_t*>, fused_program_t> fused_programs;
+    /* Frame timing ids of runs of point-wise effects, named after all owners */
+    std::map<std::vector<pixel_effect_t*>, int> fused_timing_ids;
+
     output_t *output;
     uint32_t output_width, output_height;
-    postprocessing_manager_t(output_t *output)
+    frame_timing_recorder_t *timing;
+    postprocessing_manager_t(output_t *output, frame_timing_recorder_t *timing)
     {
         this->output = output;
+        this->timing = timing;
+    }
+
+    ~postprocessing_manager_t()
+    {
+        free_fused_programs();
     }
 
     void workaround_wlroots_backend_y_invert(wf::render_target_t& fb) const
@@ -353,30 +479,274 @@ struct postprocessing_manager_t
         output_height = height;
 
         OpenGL::render_begin();
+        post_buffers[default_out_buffer].owner = "postprocessing";
         post_buffers[default_out_buffer].allocate(width, height);
         OpenGL::render_end();
     }
 
-    void add_post(post_hook_t *hook)
+    void add_post_effect(post_effect_t effect, void *key, const std::string& owner)
     {
-        post_effects.push_back(hook);
+        owners[key] = owner.empty() ? "unnamed" : owner;
+        effect.timing_id = timing->register_hook(owners[key], "postprocess");
+        post_effects.push_back(effect);
         output->render->damage_whole_idle();
     }
 
-    void rem_post(post_hook_t *hook)
+    void rem_post_effect(void *key)
     {
-        post_effects.remove_all(hook);
+        post_effects.remove_if([=] (const post_effect_t& effect)
+        {
+            return (effect.hook == key) || (effect.pixel == key);
+        });
+        owners.erase(key);
         output->render->damage_whole_idle();
     }
 
+    void add_post(post_hook_t *hook, const std::string& owner)
+    {
+        add_post_effect(post_effect_t{hook, nullptr}, hook, owner);
+    }
+
+    void rem_post(post_hook_t *hook)
+    {
+        rem_post_effect(hook);
+    }
+
+    void add_post(pixel_effect_t *effect, const std::string& owner)
+    {
+        free_fused_programs();
+        add_post_effect(post_effect_t{nullptr, effect}, effect, owner);
+    }
+
+    void rem_post(pixel_effect_t *effect)
+    {
+        free_fused_programs();
+        rem_post_effect(effect);
+    }
+
+    void free_fused_programs()
+    {
+        // Effects may be added again at the same address
+        fused_timing_ids.clear();
+        if (fused_programs.empty())
+        {
+            return;
+        }
+
+        OpenGL::render_begin();
+        for (auto& [effects, fused] : fused_programs)
+        {
+            fused.program.free_resources();
+        }
+
+        OpenGL::render_end();
+        fused_programs.clear();
+    }
+
+    int get_fused_timing_id(const std::vector<pixel_effect_t*>& effects)
+    {
+        auto it = fused_timing_ids.find(effects);
+        if (it != fused_timing_ids.end())
+        {
+            return it->second;
+        }
+
+        std::string owner;
+        for (auto& effect : effects)
+        {
+            owner += (owner.empty() ? "" : "+") + owners[effect];
+        }
+
+        return fused_timing_ids[effects] = timing->register_hook(owner, "postprocess");
+    }
+
+    /**
+     * Post hooks process the whole output image, so they need the whole
+     * output to be repainted. Point-wise effects only need the damaged parts.
+     */
+    bool needs_full_damage()
+    {
+        bool needs_full = false;
+        post_effects.for_each([&] (const post_effect_t& effect)
+        {
+            needs_full |= (effect.hook != nullptr);
+        });
+
+        return needs_full;
+    }
+
+    /* Generate a shader which applies all given effects in order */
+    static std::string generate_fused_shader(const std::vector<pixel_effect_t*>& effects)
+    {
+        std::string source =
+            "#version 100\n"
+            "precision mediump float;\n"
+            "varying highp vec2 uvpos;\n"
+            "uniform sampler2D smp;\n";
+
+        // Each effect defines a function called effect, rename them
+        for (size_t i = 0; i < effects.size(); i++)
+        {
+            source += "#define effect effect_" + std::to_string(i) + "\n";
+            source += effects[i]->source + "\n";
+            source += "#undef effect\n";
+        }
+
+        source += "void main()\n{\n    mediump vec4 color = texture2D(smp, uvpos);\n";
+        for (size_t i = 0; i < effects.size(); i++)
+        {
+            source += "    color = effect_" + std::to_string(i) + "(color);\n";
+        }
+
+        source += "    gl_FragColor = color;\n}\n";
+        return source;
+    }
+
+    /**
+     * Apply a run of point-wise effects in a single pass. Only the parts of
+     * @destination in @damage are updated.
+     */
+    void run_pixel_effects(const std::vector<pixel_effect_t*>& effects,
+        const wf::framebuffer_t& source, const wf::framebuffer_t& destination,
+        const wf::region_t& damage)
+    {
+        static const float vertex_data[] = {
+            -1.0f, -1.0f,
+            1.0f, -1.0f,
+            1.0f, 1.0f,
+            -1.0f, 1.0f
+        };
+
+        static const float coord_data[] = {
+            0.0f, 0.0f,
+            1.0f, 0.0f,
+            1.0f, 1.0f,
+            0.0f, 1.0f
+        };
+
+        OpenGL::render_begin(destination);
+        if (!fused_programs.count(effects))
+        {
+            // Compiled only once, even if it fails
+            auto& fused = fused_programs[effects];
+            GLuint id = OpenGL::compile_program(fused_pixel_vertex_source,
+                generate_fused_shader(effects));
+
+            GLint status = GL_FALSE;
+            GL_CALL(glGetProgramiv(id, GL_LINK_STATUS, &status));
+            if (status != GL_TRUE)
+            {
+                LOGE("Failed to link fused shader for ", effects.size(),
+                    " effects on ", output->to_string());
+                GL_CALL(glDeleteProgram(id));
+                id = 0;
+            } else
+            {
+                LOGD("Compiled fused shader for ", effects.size(), " effects on ",
+                    output->to_string());
+            }
+
+            fused.program.set_simple(id);
+            for (auto& effect : effects)
+            {
+                fused.uniforms.emplace_back();
+                for (auto& name : effect->uniforms)
+                {
+                    fused.uniforms.back().push_back(fused.program.get_uniform(name));
+                }
+            }
+        }
+
+        auto& fused   = fused_programs[effects];
+        auto& program = fused.program;
+        if (!program.get_program_id(wf::TEXTURE_TYPE_RGBA))
+        {
+            OpenGL::render_end();
+            return;
+        }
+
+        program.use(wf::TEXTURE_TYPE_RGBA);
+        GL_CALL(glActiveTexture(GL_TEXTURE0));
+        GL_CALL(glBindTexture(GL_TEXTURE_2D, source.tex));
+        program.attrib_pointer("position", 2, 0, vertex_data);
+        program.attrib_pointer("uvPosition", 2, 0, coord_data);
+        for (size_t i = 0; i < effects.size(); i++)
+        {
+            if (effects[i]->set_uniforms)
+            {
+                effects[i]->set_uniforms(program, fused.uniforms[i]);
+            }
+        }
+
+        /* The damage is in the coordinate system of the transformed output,
+         * map it onto the framebuffer like the scene was rendered. */
+        int width, height;
+        wlr_output_transformed_resolution(output->handle, &width, &height);
+        wf::render_target_t target;
+        target.geometry     = {0, 0, width, height};
+        target.wl_transform = output->handle->transform;
+        target.viewport_width  = destination.viewport_width;
+        target.viewport_height = destination.viewport_height;
+        workaround_wlroots_backend_y_invert(target);
+
+        GL_CALL(glDisable(GL_BLEND));
+        for (const auto& rect : damage)
+        {
+            target.logic_scissor(wlr_box_from_pixman_box(rect));
+            GL_CALL(glDrawArrays(GL_TRIANGLE_FAN, 0, 4));
+        }
+
+        GL_CALL(glEnable(GL_BLEND));
+        GL_CALL(glBindTexture(GL_TEXTURE_2D, 0));
+
+        program.deactivate();
+        OpenGL::render_end();
+    }
+
     /* Run all postprocessing effects, rendering to alternating buffers and
-     * finally to the screen.
+     * finally to the screen. Consecutive point-wise effects are run in a
+     * single pass, which updates only the damaged region.
      *
      * NB: 2 buffers just aren't enough. We render to the zero buffer, and then
      * we alternately render to the second and the third. The reason: We track
      * damage. So, we need to keep the whole buffer each frame. */
-    void run_post_effects()
+    void run_post_effects(const wf::region_t& damage)
     {
+        struct pass_t
+        {
+            post_hook_t *hook = nullptr;
+            std::vector<pixel_effect_t*> pixel;
+            int timing_id = -1;
+        };
+
+        std::vector<pass_t> passes;
+        post_effects.for_each([&] (const post_effect_t& effect)
+        {
+            if (effect.pixel && !passes.empty() && !passes.back().pixel.empty())
+            {
+                passes.back().pixel.push_back(effect.pixel);
+                return;
+            }
+
+            pass_t pass;
+            pass.hook = effect.hook;
+            if (effect.pixel)
+            {
+                pass.pixel.push_back(effect.pixel);
+            }
+
+            pass.timing_id = effect.timing_id;
+            passes.push_back(std::move(pass));
+        });
+
+        for (auto& pass : passes)
+        {
+            if (pass.pixel.size() > 1)
+            {
+                pass.timing_id = get_fused_timing_id(pass.pixel);
+            }
+        }
+
         wf::framebuffer_t default_framebuffer;
         default_framebuffer.fb  = output_fb;
         default_framebuffer.tex = 0;
@@ -384,24 +754,36 @@ struct postprocessing_manager_t
         int last_buffer_idx = default_out_buffer;
         int next_buffer_idx = 1;
 
-        post_effects.for_each([&] (auto post) -> void
+        for (size_t i = 0; i < passes.size(); i++)
         {
-            /* The last postprocessing hook renders directly to the screen, others to
-             * the currently free buffer */
+            /* The last postprocessing pass renders directly to the screen,
+             * others to the currently free buffer */
             wf::framebuffer_t& next_buffer =
-                (post == post_effects.back() ? default_framebuffer :
+                (i == passes.size() - 1 ? default_framebuffer :
                     post_buffers[next_buffer_idx]);
 
             OpenGL::render_begin();
             /* Make sure we have the correct resolution */
+            next_buffer.owner = "postprocessing";
             next_buffer.allocate(output_width, output_height);
             OpenGL::render_end();
 
-            (*post)(post_buffers[last_buffer_idx], next_buffer);
+            const int64_t start = frame_timing_recorder_t::now();
+            if (passes[i].hook)
+            {
+                (*passes[i].hook)(post_buffers[last_buffer_idx], next_buffer);
+            } else
+            {
+                run_pixel_effects(passes[i].pixel, post_buffers[last_buffer_idx],
+                    next_buffer, damage);
+            }
+
+            timing->record_hook(passes[i].timing_id,
+                frame_timing_recorder_t::now() - start);
 
             last_buffer_idx  = next_buffer_idx;
             next_buffer_idx ^= 0b11; // alternate 1 and 2
-        });
+        }
     }
 
     wf::render_target_t get_target_framebuffer() const
@@ -726,6 +1108,7 @@ class wf::render_manager::impl
     std::unique_ptr<postprocessing_manager_t> postprocessing;
     std::unique_ptr<depth_buffer_manager_t> depth_buffer_manager;
     std::unique_ptr<repaint_delay_manager_t> delay_manager;
+    frame_timing_recorder_t timing;
 
     wf::option_wrapper_t<wf::color_t> background_color_opt;
 
@@ -733,8 +1116,8 @@ class wf::render_manager::impl
         output(o)
     {
         output_damage = std::make_unique<output_damage_t>(o);
-        effects = std::make_unique<effect_hook_manager_t>();
-        postprocessing = std::make_unique<postprocessing_manager_t>(o);
+        effects = std::make_unique<effect_hook_manager_t>(&timing);
+        postprocessing = std::make_unique<postprocessing_manager_t>(o, &timing);
         depth_buffer_manager = std::make_unique<depth_buffer_manager_t>();
         delay_manager = std::make_unique<repaint_delay_manager_t>(o);
 
@@ -949,22 +1332,38 @@ class wf::render_manager::impl
      */
     void paint()
     {
+        timing.begin_frame();
+
+        /* Part 0: propagate the damage which views recorded since the last
+         * frame of any output */
+        flush_damage();
+
         /* Part 1: frame setup: query damage, etc. */
+        timing.begin_phase(FRAME_PHASE_EFFECTS);
         effects->run_effects(OUTPUT_EFFECT_PRE);
         effects->run_effects(OUTPUT_EFFECT_DAMAGE);
+        timing.end_phase(FRAME_PHASE_EFFECTS);
 
-        if (do_direct_scanout())
+        timing.begin_phase(FRAME_PHASE_SCANOUT);
+        const bool scanout = do_direct_scanout();
+        timing.end_phase(FRAME_PHASE_SCANOUT);
+        if (scanout)
         {
             // Yet another optimization: if we can directly scanout, we should
             // stop the rest of the repaint cycle.
+            timing.end_frame(FRAME_RESULT_SCANOUT);
             return;
         }
 
         bool needs_swap;
-        if (!output_damage->make_current(needs_swap))
+        timing.begin_phase(FRAME_PHASE_MAKE_CURRENT);
+        const bool attached = output_damage->make_current(needs_swap);
+        timing.end_phase(FRAME_PHASE_MAKE_CURRENT);
+        if (!attached)
         {
             wlr_output_rollback(output->handle);
             delay_manager->skip_frame();
+            timing.end_frame(FRAME_RESULT_SKIPPED);
             return;
         }
 
@@ -975,6 +1374,7 @@ class wf::render_manager::impl
              * repaint */
             wlr_output_rollback(output->handle);
             delay_manager->skip_frame();
+            timing.end_frame(FRAME_RESULT_SKIPPED);
             return;
         }
 
@@ -982,23 +1382,41 @@ class wf::render_manager::impl
         // Doing this earlier may mean that the damage from the previous frames
         // creeps into the current frame damage, if we had skipped a frame.
         output_damage->accumulate_damage();
+        output_damage->simplify_damage();
 
         update_bound_output();
 
+        OpenGL::render_begin();
+        timing.begin_gpu_timer();
+        OpenGL::render_end();
+
         /* Part 2: call the renderer, which sets swap_damage and
          * draws the scenegraph */
+        auto& scene_priv = wf::get_core().scene()->priv;
+        scene_priv->culled_instances = 0;
+        const uint64_t gl_calls_start = OpenGL::get_gl_call_count();
+
+        timing.begin_phase(FRAME_PHASE_RENDER);
         render_output();
+        timing.end_phase(FRAME_PHASE_RENDER);
+
+        LOGC(RENDER, "Output ", output->to_string(), ": culled ",
+            scene_priv->culled_instances, " render instances, ",
+            OpenGL::get_gl_call_count() - gl_calls_start, " GL calls");
 
         /* Part 3: overlay effects */
+        timing.begin_phase(FRAME_PHASE_OVERLAY);
         effects->run_effects(OUTPUT_EFFECT_OVERLAY);
+        timing.end_phase(FRAME_PHASE_OVERLAY);
 
-        if (postprocessing->post_effects.size())
+        if (postprocessing->needs_full_damage())
         {
             swap_damage |= output_damage->get_wlr_damage_box();
         }
 
         /* Part 4: finalize the scene: postprocessing effects */
-        postprocessing->run_post_effects();
+        timing.begin_phase(FRAME_PHASE_POSTPROCESS);
+        postprocessing->run_post_effects(swap_damage);
         if (output_inhibit_counter)
         {
             OpenGL::render_begin(output->handle->width, output->handle->height,
@@ -1007,22 +1425,54 @@ class wf::render_manager::impl
             OpenGL::render_end();
         }
 
+        timing.end_phase(FRAME_PHASE_POSTPROCESS);
+
         /* Part 5: render sw cursors
          * We render software cursors after everything else
          * for consistency with hardware cursor planes */
+        timing.begin_phase(FRAME_PHASE_CURSORS);
         OpenGL::render_begin();
         wlr_renderer_begin(wf::get_core().renderer,
             output->handle->width, output->handle->height);
         wlr_output_render_software_cursors(output->handle,
             swap_damage.to_pixman());
         wlr_renderer_end(wf::get_core().renderer);
+        timing.end_gpu_timer();
         OpenGL::render_end();
+        timing.end_phase(FRAME_PHASE_CURSORS);
 
         /* Part 6: finalize frame: swap buffers, send frame_done, etc */
+        timing.begin_phase(FRAME_PHASE_SWAP);
         OpenGL::unbind_output(output);
         output_damage->swap_buffers(swap_damage);
         swap_damage.clear();
+        timing.end_phase(FRAME_PHASE_SWAP);
+
+        timing.begin_phase(FRAME_PHASE_POST_EFFECTS);
         post_paint();
+        timing.end_phase(FRAME_PHASE_POST_EFFECTS);
+        timing.end_frame(FRAME_RESULT_RENDERED);
+    }
+
+    /**
+     * Propagate the pending damage of all views, see wf::flush_view_damage().
+     */
+    void flush_damage()
+    {
+        auto& scene_priv = wf::get_core().scene()->priv;
+        const int64_t start = frame_timing_recorder_t::now();
+        wf::flush_view_damage();
+
+        if (scene_priv->flushed_damage_views)
+        {
+            LOGC(RENDER, "Output ", output->to_string(), ": coalesced ",
+                scene_priv->recorded_damage_boxes, " damaged boxes of ",
+                scene_priv->flushed_damage_views, " views in ",
+                (frame_timing_recorder_t::now() - start) / 1000, "us");
+        }
+
+        scene_priv->recorded_damage_boxes = 0;
+        scene_priv->flushed_damage_views  = 0;
     }
 
     /**
@@ -1038,9 +1488,18 @@ class wf::render_manager::impl
         }
     }
 
+    /**
+     * Send frame_done to the surfaces of the views in the subtree of @root,
+     * from the topmost to the bottommost view.
+     *
+     * @param visible The part of the output which is not covered by opaque
+     *   views above, in output-local coordinates. The opaque regions of views
+     *   without transformers are subtracted from it.
+     * @param send_occluded Whether to send frame_done to views which are fully
+     *   occluded or outside of the visible workspace as well.
+     */
     void send_frame_done_recursive(wf::scene::node_ptr root,
-        std::optional<wf::geometry_t> limit,
-        const timespec& repaint_ended)
+        wf::region_t& visible, bool send_occluded, const timespec& repaint_ended)
     {
         if (!root->is_enabled())
         {
@@ -1056,26 +1515,43 @@ class wf::render_manager::impl
                     continue;
                 }
 
-                if (limit && !(view->get_bounding_box() & *limit))
+                const bool is_visible =
+                    !(visible & view->get_bounding_box()).empty();
+                if (is_visible || send_occluded)
                 {
-                    continue;
+                    for (auto& child : view->enumerate_surfaces())
+                    {
+                        child.surface->send_frame_done(repaint_ended);
+                    }
                 }
 
-                for (auto& child : view->enumerate_surfaces())
+                if (!view->has_transformer())
                 {
-                    child.surface->send_frame_done(repaint_ended);
+                    auto origin = wf::origin(view->get_output_geometry());
+                    for (auto& child : view->enumerate_surfaces(origin))
+                    {
+                        visible ^= child.surface->get_opaque_region(child.position);
+                    }
                 }
             }
         }
 
         for (auto& ch : root->get_children())
         {
-            send_frame_done_recursive(ch, limit, repaint_ended);
+            send_frame_done_recursive(ch, visible, send_occluded, repaint_ended);
         }
     }
 
+    wf::option_wrapper_t<int> occluded_frame_rate{"core/occluded_frame_rate"};
+    int64_t last_occluded_frame_done = 0;
+
     /**
      * Send frame_done to clients.
+     *
+     * Visible surfaces get it after every frame. Surfaces which are fully
+     * occluded by opaque views, or are not on the current workspace, get it
+     * only core/occluded_frame_rate times per second, so that hidden clients
+     * do not keep rendering at the full refresh rate.
      */
     void send_frame_done()
     {
@@ -1084,25 +1560,120 @@ class wf::render_manager::impl
             wlr_backend_get_presentation_clock(wf::get_core_impl().backend);
         clock_gettime(presentation_clock, &repaint_ended);
 
-        // TODO: during rendering, we should build a list of rendered surfaces and
-        // send them all frame done instead of recalculating here.
-        for (int i = 0; i < (int)wf::scene::layer::ALL_LAYERS; i++)
+        bool send_occluded = true;
+        if (occluded_frame_rate > 0)
         {
-            if (renderer)
+            const int64_t now = wf::get_current_time();
+            send_occluded = (now - last_occluded_frame_done) >=
+                1000 / occluded_frame_rate;
+            if (send_occluded)
             {
-                send_frame_done_recursive(output->node_for_layer(
-                    (wf::scene::layer)i), {}, repaint_ended);
-            } else
-            {
-                auto limit = output->render->get_ws_box(
-                    output->workspace->get_current_workspace());
-                send_frame_done_recursive(output->node_for_layer(
-                    (wf::scene::layer)i), limit, repaint_ended);
+                last_occluded_frame_done = now;
             }
         }
+
+        // Custom renderers may show any part of the scenegraph, so assume
+        // everything is visible.
+        wf::region_t visible = output->render->get_ws_box(
+            output->workspace->get_current_workspace());
+        send_occluded |= (bool)renderer;
+
+        for (int i = (int)wf::scene::layer::ALL_LAYERS - 1; i >= 0; i--)
+        {
+            send_frame_done_recursive(output->node_for_layer(
+                (wf::scene::layer)i), visible, send_occluded, repaint_ended);
+        }
     }
 };
 
+/**
+ * Whether instructions for the given targets can be drawn in the same batch.
+ */
+static bool can_batch(const wf::render_target_t& a, const wf::render_target_t& b)
+{
+    return a.fb == b.fb && a.viewport_width == b.viewport_width &&
+           a.viewport_height == b.viewport_height && a.scale == b.scale;
+}
+
+/**
+ * Gather instructions, front to back. Opaque instances subtract their opaque
+ * region from the damage, and instances below them are culled once nothing
+ * remains to be repainted.
+ */
+static std::vector<scene::render_instruction_t> schedule_pass_instructions(
+    std::vector<scene::render_instance_uptr>& instances,
+    const wf::render_target_t& target, wf::region_t& damage)
+{
+    std::vector<wf::scene::render_instruction_t> instructions;
+    scene::schedule_instructions_culled(instances, instructions, target, damage);
+
+    // Instructions whose damage is empty would not draw anything, but they may
+    // still be expensive (e.g. transformers render their children offscreen).
+    const size_t scheduled = instructions.size();
+    instructions.erase(std::remove_if(instructions.begin(), instructions.end(),
+        [] (const wf::scene::render_instruction_t& instr)
+    {
+        return instr.damage.empty();
+    }), instructions.end());
+    wf::get_core().scene()->priv->culled_instances +=
+        scheduled - instructions.size();
+
+    return instructions;
+}
+
+static void clear_background(const wf::render_target_t& target,
+    const wf::region_t& damage, const wf::color_t& color)
+{
+    OpenGL::render_begin(target);
+    for (const auto& rect : damage)
+    {
+        target.logic_scissor(wlr_box_from_pixman_box(rect));
+        OpenGL::clear(color, GL_COLOR_BUFFER_BIT);
+    }
+
+    OpenGL::render_end();
+}
+
+/**
+ * Render the instructions back to front. Consecutive instructions which just
+ * draw a texture are collected and drawn in batches.
+ */
+static void execute_instructions(
+    std::vector<scene::render_instruction_t>& instructions,
+    wf::output_t *reference_output)
+{
+    OpenGL::texture_batch_t batch;
+    const wf::render_target_t *batch_target = nullptr;
+    for (auto& instr : wf::reverse(instructions))
+    {
+        auto quad = instr.instance->get_texture_quad();
+        if (batch_target && (!quad || !can_batch(*batch_target, instr.target)))
+        {
+            batch.draw(*batch_target);
+            batch_target = nullptr;
+        }
+
+        if (quad)
+        {
+            batch.add(quad->texture, quad->geometry, instr.target, instr.damage);
+            batch_target = &instr.target;
+        } else
+        {
+            instr.instance->render(instr.target, instr.damage);
+        }
+
+        if (reference_output)
+        {
+            instr.instance->presentation_feedback(reference_output);
+        }
+    }
+
+    if (batch_target)
+    {
+        batch.draw(*batch_target);
+    }
+}
+
 wf::region_t scene::run_render_pass(
     const render_pass_params_t& params, uint32_t flags)
 {
@@ -1117,45 +1688,123 @@ wf::region_t scene::run_render_pass(
 
     wf::region_t swap_damage = accumulated_damage;
 
-    // Gather instructions
-    std::vector<wf::scene::render_instruction_t> instructions;
-    for (auto& inst : *params.instances)
-    {
-        inst->schedule_instructions(instructions,
-            params.target, accumulated_damage);
-    }
+    auto instructions = schedule_pass_instructions(*params.instances,
+        params.target, accumulated_damage);
 
     // Clear visible background areas
     if (flags & RPASS_CLEAR_BACKGROUND)
     {
-        OpenGL::render_begin(params.target);
-        for (const auto& rect : accumulated_damage)
+        clear_background(params.target, accumulated_damage,
+            params.background_color);
+    }
+
+    execute_instructions(instructions, params.reference_output);
+
+    if (flags & RPASS_EMIT_SIGNALS)
+    {
+        render_pass_end_signal end_ev;
+        end_ev.target = params.target;
+        wf::get_core().emit(&end_ev);
+    }
+
+    return swap_damage;
+}
+
+void scene::run_multi_target_render_pass(
+    std::vector<render_instance_uptr>& instances,
+    std::vector<render_pass_target_t>& targets, wf::output_t *reference_output,
+    uint32_t flags)
+{
+    if (targets.empty())
+    {
+        return;
+    }
+
+    // Instructions are scheduled once for a target spanning all targets.
+    // Damage and opaque regions are in the same coordinate system for all of
+    // them, so culling works across targets as well.
+    auto shared_target = targets.front().target;
+    wf::region_t total_damage;
+    int x1 = shared_target.geometry.x;
+    int y1 = shared_target.geometry.y;
+    int x2 = x1 + shared_target.geometry.width;
+    int y2 = y1 + shared_target.geometry.height;
+    for (auto& t : targets)
+    {
+        if (flags & RPASS_EMIT_SIGNALS)
         {
-            params.target.logic_scissor(wlr_box_from_pixman_box(rect));
-            OpenGL::clear(params.background_color, GL_COLOR_BUFFER_BIT);
+            scene::render_pass_begin_signal ev{t.damage, t.target};
+            wf::get_core().emit(&ev);
         }
 
-        OpenGL::render_end();
+        // Like the return value of run_render_pass(), the damage of each
+        // target is what is repainted on it.
+        t.damage &= t.target.geometry;
+        total_damage |= t.damage;
+        x1 = std::min(x1, t.target.geometry.x);
+        y1 = std::min(y1, t.target.geometry.y);
+        x2 = std::max(x2, t.target.geometry.x + t.target.geometry.width);
+        y2 = std::max(y2, t.target.geometry.y + t.target.geometry.height);
+        shared_target.scale = std::max(shared_target.scale, t.target.scale);
     }
 
-    // Render instances
-    for (auto& instr : wf::reverse(instructions))
+    shared_target.geometry = {x1, y1, x2 - x1, y2 - y1};
+    auto instructions = schedule_pass_instructions(instances, shared_target,
+        total_damage);
+
+    // Dispatch the instructions to each target
+    std::vector<render_instruction_t> dispatched;
+    for (auto& t : targets)
     {
-        instr.instance->render(instr.target, instr.damage);
-        if (params.reference_output)
+        if (t.damage.empty())
+        {
+            continue;
+        }
+
+        if (flags & RPASS_CLEAR_BACKGROUND)
+        {
+            clear_background(t.target, total_damage & t.target.geometry,
+                t.background_color);
+        }
+
+        dispatched.clear();
+        for (auto& instr : instructions)
         {
-            instr.instance->presentation_feedback(params.reference_output);
+            // Instances may have scheduled themselves with a translated
+            // target, for example views with a surface offset. Translate the
+            // target the same way.
+            auto delta = wf::origin(instr.target.geometry) -
+                wf::origin(shared_target.geometry);
+            auto target = t.target;
+            target.geometry = t.target.geometry + delta;
+
+            auto damage = instr.damage & target.geometry;
+            if (!damage.empty())
+            {
+                dispatched.push_back({instr.instance, target, std::move(damage)});
+            }
         }
+
+        execute_instructions(dispatched, nullptr);
     }
 
-    if (flags & RPASS_EMIT_SIGNALS)
+    if (reference_output)
     {
-        render_pass_end_signal end_ev;
-        end_ev.target = params.target;
-        wf::get_core().emit(&end_ev);
+        for (auto& instr : instructions)
+        {
+            instr.instance->presentation_feedback(reference_output);
+        }
     }
 
-    return swap_damage;
+    if (flags & RPASS_EMIT_SIGNALS)
+    {
+        for (auto& t : targets)
+        {
+            render_pass_end_signal end_ev;
+            end_ev.target = t.target;
+            wf::get_core().emit(&end_ev);
+        }
+    }
 }
 
 scene::direct_scanout scene::try_scanout_from_list(
@@ -1203,9 +1852,10 @@ void render_manager::add_inhibit(bool add)
     pimpl->add_inhibit(add);
 }
 
-void render_manager::add_effect(effect_hook_t *hook, output_effect_type_t type)
+void render_manager::add_effect(effect_hook_t *hook, output_effect_type_t type,
+    const std::string& owner)
 {
-    pimpl->effects->add_effect(hook, type);
+    pimpl->effects->add_effect(hook, type, owner);
 }
 
 void render_manager::rem_effect(effect_hook_t *hook)
@@ -1213,9 +1863,9 @@ void render_manager::rem_effect(effect_hook_t *hook)
     pimpl->effects->rem_effect(hook);
 }
 
-void render_manager::add_post(post_hook_t *hook)
+void render_manager::add_post(post_hook_t *hook, const std::string& owner)
 {
-    pimpl->postprocessing->add_post(hook);
+    pimpl->postprocessing->add_post(hook, owner);
 }
 
 void render_manager::rem_post(post_hook_t *hook)
@@ -1223,6 +1873,16 @@ void render_manager::rem_post(post_hook_t *hook)
     pimpl->postprocessing->rem_post(hook);
 }
 
+void render_manager::add_post(pixel_effect_t *effect, const std::string& owner)
+{
+    pimpl->postprocessing->add_post(effect, owner);
+}
+
+void render_manager::rem_post(pixel_effect_t *effect)
+{
+    pimpl->postprocessing->rem_post(effect);
+}
+
 wf::region_t render_manager::get_scheduled_damage()
 {
     return pimpl->output_damage->get_scheduled_damage();
@@ -1257,6 +1917,16 @@ wf::render_target_t render_manager::get_target_framebuffer() const
 {
     return pimpl->postprocessing->get_target_framebuffer();
 }
+
+wf::frame_timing_stats_t render_manager::get_frame_timing() const
+{
+    return pimpl->timing.get_stats();
+}
+
+void render_manager::reset_frame_timing()
+{
+    pimpl->timing.reset();
+}
 } // namespace wf
 
 /* End render_manager */
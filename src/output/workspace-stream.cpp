@@ -7,35 +7,44 @@
 #include <wayfire/output.hpp>
 #include <wayfire/render-manager.hpp>
 #include <wayfire/workspace-manager.hpp>
+#include <algorithm>
+#include <cmath>
 
 namespace wf
 {
-void workspace_stream_t::update_instances()
+/** Generate render instances for all layers of the output, top to bottom. */
+static void gen_output_instances(wf::output_t *output,
+    std::vector<scene::render_instance_uptr>& instances,
+    scene::damage_callback push_damage)
 {
-    if (!this->current_output)
-    {
-        return;
-    }
-
-    auto acc_damage = [this] (const wf::region_t& damage)
-    {
-        this->accumulated_damage |= damage;
-    };
-
-    this->instances.clear();
+    instances.clear();
     for (int layer = (int)scene::layer::ALL_LAYERS - 1; layer >= 0; layer--)
     {
-        auto layer_root = current_output->node_for_layer((scene::layer)layer);
+        auto layer_root = output->node_for_layer((scene::layer)layer);
         for (auto& ch : layer_root->get_children())
         {
             if (ch->is_enabled())
             {
-                ch->gen_render_instances(this->instances, acc_damage);
+                ch->gen_render_instances(instances, push_damage);
             }
         }
     }
 }
 
+void workspace_stream_t::update_instances()
+{
+    if (!this->current_output)
+    {
+        return;
+    }
+
+    gen_output_instances(current_output, instances,
+        [this] (const wf::region_t& damage)
+    {
+        this->accumulated_damage |= damage;
+    });
+}
+
 void workspace_stream_t::start_for_workspace(wf::output_t *output,
     wf::point_t workspace)
 {
@@ -62,44 +71,89 @@ void workspace_stream_t::start_for_workspace(wf::output_t *output,
     this->update_instances();
 }
 
-void workspace_stream_t::render_frame()
+void workspace_stream_t::set_scale(float scale)
 {
-    wf::dassert(current_output != nullptr,
-        "Inactive workspace stream being rendered?");
-
-    this->accumulated_damage &= current_output->render->get_ws_box(ws);
-    if (this->accumulated_damage.empty())
+    float rounded = 1.0;
+    while ((rounded / 2 >= scale) && (rounded / 2 >= MIN_SCALE))
     {
-        return;
+        rounded /= 2;
     }
 
+    this->scale = rounded;
+}
+
+float workspace_stream_t::get_scale() const
+{
+    return scale;
+}
+
+wf::dimensions_t workspace_stream_t::get_buffer_size(wf::output_t *output) const
+{
+    return {
+        std::max(1, (int)std::ceil(output->handle->width * scale)),
+        std::max(1, (int)std::ceil(output->handle->height * scale)),
+    };
+}
+
+wf::render_target_t workspace_stream_t::prepare_target(wf::output_t *output)
+{
+    auto size = get_buffer_size(output);
     OpenGL::render_begin();
-    buffer.allocate(current_output->handle->width, current_output->handle->height);
+    buffer.owner = "workspace-stream";
+    buffer.allocate(size.width, size.height);
     OpenGL::render_end();
 
-    scene::render_pass_params_t params;
-
-    params.target = current_output->render->get_target_framebuffer();
+    auto target = output->render->get_target_framebuffer();
 
     /* Use the workspace buffers */
-    params.target.fb  = this->buffer.fb;
-    params.target.tex = this->buffer.tex;
-
-    auto g   = current_output->get_relative_geometry();
-    auto cws = current_output->workspace->get_current_workspace();
-    params.target.geometry.x = (ws.x - cws.x) * g.width,
-    params.target.geometry.y = (ws.y - cws.y) * g.height;
+    target.fb  = this->buffer.fb;
+    target.tex = this->buffer.tex;
+    target.viewport_width  = size.width;
+    target.viewport_height = size.height;
+    target.scale *= scale;
+
+    auto g   = output->get_relative_geometry();
+    auto cws = output->workspace->get_current_workspace();
+    target.geometry.x = (ws.x - cws.x) * g.width,
+    target.geometry.y = (ws.y - cws.y) * g.height;
+    return target;
+}
 
+wf::color_t workspace_stream_t::get_background_color() const
+{
     wf::option_wrapper_t<wf::color_t> background_color_opt{"core/background_color"};
-    params.background_color =
-        (this->background.a < 0 ? background_color_opt : this->background);
+    return (this->background.a < 0 ? background_color_opt : this->background);
+}
 
+void workspace_stream_t::render_frame()
+{
+    wf::dassert(current_output != nullptr,
+        "Inactive workspace stream being rendered?");
+
+    auto size = get_buffer_size(current_output);
+    if ((size.width != buffer.viewport_width) ||
+        (size.height != buffer.viewport_height))
+    {
+        // The old contents are at a different resolution
+        this->accumulated_damage |= current_output->render->get_ws_box(ws);
+    }
+
+    this->accumulated_damage &= current_output->render->get_ws_box(ws);
+    if (this->accumulated_damage.empty())
+    {
+        return;
+    }
+
+    scene::render_pass_params_t params;
+    params.target    = prepare_target(current_output);
+    params.background_color = get_background_color();
     params.instances = &this->instances;
     params.damage    = accumulated_damage;
     params.reference_output = current_output;
 
     scene::run_render_pass(params,
         scene::RPASS_EMIT_SIGNALS | scene::RPASS_CLEAR_BACKGROUND);
+    this->accumulated_damage.clear();
 }
 
 void workspace_stream_t::stop()
@@ -109,4 +163,75 @@ void workspace_stream_t::stop()
     this->instances.clear();
     regen_instances.disconnect();
 }
+
+workspace_stream_renderer_t::workspace_stream_renderer_t(wf::output_t *output)
+{
+    this->output = output;
+    on_root_update = [=] (scene::root_node_update_signal *data)
+    {
+        if ((data->flags & scene::update_flag::ENABLED) ||
+            (data->flags & scene::update_flag::CHILDREN_LIST))
+        {
+            update_instances();
+        }
+    };
+
+    wf::get_core().scene()->connect(&on_root_update);
+    update_instances();
+
+    // Nothing was tracked before the renderer was created
+    auto grid = output->workspace->get_workspace_grid_size();
+    for (int i = 0; i < grid.width; i++)
+    {
+        for (int j = 0; j < grid.height; j++)
+        {
+            damage |= output->render->get_ws_box({i, j});
+        }
+    }
+}
+
+void workspace_stream_renderer_t::update_instances()
+{
+    gen_output_instances(output, instances, [this] (const wf::region_t& region)
+    {
+        this->damage |= region;
+    });
+}
+
+void workspace_stream_renderer_t::render(
+    const std::vector<workspace_stream_t*>& streams)
+{
+    std::vector<scene::render_pass_target_t> targets;
+    for (auto& stream : streams)
+    {
+        auto box  = output->render->get_ws_box(stream->ws);
+        auto size = stream->get_buffer_size(output);
+
+        wf::region_t stream_damage = (damage | stream->accumulated_damage) & box;
+        if ((size.width != stream->buffer.viewport_width) ||
+            (size.height != stream->buffer.viewport_height))
+        {
+            // New buffer, or the old contents are at a different resolution
+            stream_damage |= box;
+        }
+
+        // Damage on workspaces which are not rendered now is kept until they
+        // are rendered.
+        damage ^= box;
+        stream->accumulated_damage.clear();
+        if (stream_damage.empty())
+        {
+            continue;
+        }
+
+        targets.push_back(scene::render_pass_target_t{
+            .target = stream->prepare_target(output),
+            .damage = std::move(stream_damage),
+            .background_color = stream->get_background_color(),
+        });
+    }
+
+    scene::run_multi_target_render_pass(instances, targets, output,
+        scene::RPASS_EMIT_SIGNALS | scene::RPASS_CLEAR_BACKGROUND);
+}
 }
@@ -1,5 +1,7 @@
 #include <wayfire/region.hpp>
 #include <wayfire/nonstd/wlroots-full.hpp>
+#include <algorithm>
+#include <vector>
 
 /* Pixman helpers */
 wlr_box wlr_box_from_pixman_box(const pixman_box32_t& box)
@@ -253,6 +255,141 @@ wf::region_t& wf::region_t::operator ^=(const wf::region_t& other)
     return *this;
 }
 
+int wf::region_t::rect_count() const
+{
+    return pixman_region32_n_rects(unconst());
+}
+
+namespace
+{
+struct merge_box_t
+{
+    pixman_box32_t box;
+    /* The area of the original rectangles merged into the box */
+    int64_t covered;
+};
+
+int64_t box_area(const pixman_box32_t& box)
+{
+    return int64_t(box.x2 - box.x1) * (box.y2 - box.y1);
+}
+
+pixman_box32_t box_union(const pixman_box32_t& a, const pixman_box32_t& b)
+{
+    return {
+        std::min(a.x1, b.x1), std::min(a.y1, b.y1),
+        std::max(a.x2, b.x2), std::max(a.y2, b.y2),
+    };
+}
+
+/* The fraction of the bounding box of a and b which neither of them covers */
+double merge_overhead(const merge_box_t& a, const merge_box_t& b)
+{
+    const double area = box_area(box_union(a.box, b.box));
+    return std::max(0.0, (area - a.covered - b.covered) / area);
+}
+
+/* Pixman sorts rectangles by their y and then x coordinate, so rectangles which
+ * are close to each other are usually close in the list too. Looking only at
+ * a window of the following rectangles keeps merging linear. */
+constexpr size_t MERGE_WINDOW = 8;
+
+/**
+ * Merge boxes whose overhead is at most @threshold, until no more boxes can be
+ * merged or there are only @min_count boxes left.
+ */
+void merge_boxes(std::vector<merge_box_t>& boxes, double threshold,
+    size_t min_count)
+{
+    bool merged = true;
+    while (merged && (boxes.size() > min_count))
+    {
+        merged = false;
+        size_t alive = boxes.size();
+        for (size_t i = 0; i < boxes.size() && alive > min_count; i++)
+        {
+            if (boxes[i].covered < 0)
+            {
+                continue;
+            }
+
+            const size_t last = std::min(boxes.size(), i + 1 + MERGE_WINDOW);
+            for (size_t j = i + 1; j < last && alive > min_count; j++)
+            {
+                if ((boxes[j].covered < 0) ||
+                    (merge_overhead(boxes[i], boxes[j]) > threshold))
+                {
+                    continue;
+                }
+
+                boxes[i].box = box_union(boxes[i].box, boxes[j].box);
+                boxes[i].covered += boxes[j].covered;
+                boxes[j].covered  = -1;
+                --alive;
+                merged = true;
+            }
+        }
+
+        boxes.erase(std::remove_if(boxes.begin(), boxes.end(),
+            [] (const merge_box_t& box) { return box.covered < 0; }), boxes.end());
+    }
+}
+}
+
+void wf::region_t::simplify(double max_overhead, int max_rects)
+{
+    double threshold = std::clamp(max_overhead, 0.0, 1.0);
+    size_t min_count = 1;
+    while (true)
+    {
+        int n;
+        auto rects = pixman_region32_rectangles(&_region, &n);
+        const bool over_limit = (max_rects > 0) && (n > max_rects);
+        if ((n <= 1) || ((threshold <= 0) && !over_limit))
+        {
+            return;
+        }
+
+        std::vector<merge_box_t> boxes;
+        boxes.reserve(n);
+        for (int i = 0; i < n; i++)
+        {
+            boxes.push_back({rects[i], box_area(rects[i])});
+        }
+
+        merge_boxes(boxes, threshold, min_count);
+
+        std::vector<pixman_box32_t> merged;
+        merged.reserve(boxes.size());
+        for (auto& box : boxes)
+        {
+            merged.push_back(box.box);
+        }
+
+        // Overlapping boxes are split into bands again, so the region may
+        // still have more rectangles than the merged boxes.
+        pixman_region32_fini(&_region);
+        pixman_region32_init_rects(&_region, merged.data(), merged.size());
+        if ((max_rects <= 0) || (rect_count() <= max_rects))
+        {
+            return;
+        }
+
+        if (threshold >= 1.0)
+        {
+            // Give up and use the bounding box.
+            auto extents = get_extents();
+            pixman_region32_fini(&_region);
+            pixman_region32_init_with_extents(&_region, &extents);
+            return;
+        }
+
+        // Too many rectangles: accept more overhead in the next round.
+        threshold = std::min(1.0, std::max(0.125, threshold * 2));
+        min_count = max_rects;
+    }
+}
+
 pixman_region32_t*wf::region_t::to_pixman()
 {
     return &_region;
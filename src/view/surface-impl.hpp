@@ -79,6 +79,7 @@ class wlr_surface_base_t
     virtual wf::dimensions_t _get_size() const;
     virtual void _simple_render(const wf::render_target_t& fb, int x, int y,
         const wf::region_t& damage);
+    virtual std::optional<wf::texture_t> _get_texture();
 
   protected:
     virtual void map(wlr_surface *surface);
@@ -123,6 +124,11 @@ class wlr_child_surface_base_t :
         _simple_render(fb, x, y, damage);
     }
 
+    virtual std::optional<wf::texture_t> get_texture() override
+    {
+        return _get_texture();
+    }
+
     virtual void set_output(wf::output_t *output) override
     {
         update_output(get_output(), output);
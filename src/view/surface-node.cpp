@@ -86,6 +86,19 @@ class surface_render_instance_t : public render_instance_t
         surface->simple_render(target, 0, 0, region);
     }
 
+    std::optional<texture_quad_t> get_texture_quad() override
+    {
+        if (auto texture = surface->get_texture())
+        {
+            return texture_quad_t{
+                .texture  = *texture,
+                .geometry = wf::construct_box({0, 0}, surface->get_size()),
+            };
+        }
+
+        return {};
+    }
+
     void presentation_feedback(wf::output_t *output) override
     {
         if (surface->get_wlr_surface() != nullptr)
@@ -1,4 +1,5 @@
 #include "surface-impl.hpp"
+#include "../core/scene-priv.hpp"
 #include "wayfire/debug.hpp"
 #include "wayfire/geometry.hpp"
 #include "wayfire/scene.hpp"
@@ -88,11 +89,7 @@ class surface_root_render_instance_t : public render_instance_t
 
         damage += -offset;
         our_target.geometry = our_target.geometry + -offset;
-        for (auto& ch : this->children)
-        {
-            ch->schedule_instructions(instructions, our_target, damage);
-        }
-
+        schedule_instructions_culled(children, instructions, our_target, damage);
         damage += offset;
     }
 
@@ -205,6 +205,11 @@ wlr_surface*wf::surface_interface_t::get_wlr_surface()
     return priv->wsurface;
 }
 
+std::optional<wf::texture_t> wf::surface_interface_t::get_texture()
+{
+    return {};
+}
+
 void wf::surface_interface_t::damage_surface_region(
     const wf::region_t& dmg)
 {
@@ -423,6 +428,16 @@ void wf::wlr_surface_base_t::update_output(wf::output_t *old_output,
     }
 }
 
+std::optional<wf::texture_t> wf::wlr_surface_base_t::_get_texture()
+{
+    if (!get_buffer())
+    {
+        return {};
+    }
+
+    return wf::texture_t{surface};
+}
+
 void wf::wlr_surface_base_t::_simple_render(const wf::render_target_t& fb,
     int x, int y, const wf::region_t& damage)
 {
@@ -10,6 +10,7 @@
 #include <glm/ext/matrix_transform.hpp>
 #include <string>
 #include <tuple>
+#include <typeinfo>
 #include <wayfire/view.hpp>
 #include <algorithm>
 #include <cmath>
@@ -159,6 +160,87 @@ static void transform_linear_damage(node_t *self, wf::region_t& damage)
     }
 }
 
+glm::mat4 view_2d_transformer_t::get_linear_transform()
+{
+    auto midpoint  = get_center(view->get_wm_geometry());
+    auto center_at = glm::translate(glm::mat4(1.0),
+        {-midpoint.x, -midpoint.y, 0.0});
+    auto scale = glm::scale(glm::mat4(1.0),
+        glm::vec3{scale_x, scale_y, 1.0});
+    auto rotate = glm::rotate<float>(glm::mat4(1.0), -angle,
+        glm::vec3{0.0, 0.0, 1.0});
+    auto translate = glm::translate(glm::mat4(1.0),
+        glm::vec3{translation_x + midpoint.x,
+            translation_y + midpoint.y, 0.0});
+    return translate * rotate * scale * center_at;
+}
+
+glm::vec4 view_2d_transformer_t::get_color_multiplier()
+{
+    return glm::vec4{1.0, 1.0, 1.0, alpha};
+}
+
+bool view_2d_transformer_t::is_linear_only()
+{
+    return typeid(*this) == typeid(view_2d_transformer_t);
+}
+
+bool render_linear_transformer_chain(node_t *top,
+    const wf::render_target_t& target, const wf::region_t& damage)
+{
+    // Drops the z coordinate of the points passed to the previous (outer)
+    // transformer. This is what happens when rendering each transformer to an
+    // intermediate buffer, and what the 3D transformer expects.
+    glm::mat4 flatten{1.0};
+    flatten[2][2] = 0.0;
+
+    glm::mat4 transform{1.0};
+    glm::vec4 color{1.0};
+    node_t *innermost = nullptr;
+    node_t *current   = top;
+
+    while (auto linear = dynamic_cast<linear_transformer_node_t*>(current))
+    {
+        auto children = current->get_children();
+        if ((children.size() != 1) || !linear->is_linear_only())
+        {
+            return false;
+        }
+
+        transform = innermost ?
+            transform * flatten * linear->get_linear_transform() :
+            linear->get_linear_transform();
+        color    *= linear->get_color_multiplier();
+        innermost = current;
+        current   = children.front().get();
+    }
+
+    auto zcopy = dynamic_cast<zero_copy_texturable_node_t*>(current);
+    if (!innermost || !zcopy)
+    {
+        return false;
+    }
+
+    auto tex = zcopy->to_texture();
+    if (!tex)
+    {
+        return false;
+    }
+
+    auto bbox = innermost->get_children_bounding_box();
+    auto full_matrix = target.get_orthographic_projection() * transform;
+
+    OpenGL::render_begin(target);
+    for (auto& box : damage)
+    {
+        target.logic_scissor(wlr_box_from_pixman_box(box));
+        OpenGL::render_transformed_texture(*tex, bbox, full_matrix, color);
+    }
+
+    OpenGL::render_end();
+    return true;
+}
+
 class view_2d_render_instance_t :
     public transformer_render_instance_t<view_2d_transformer_t>
 {
@@ -173,30 +255,24 @@ class view_2d_render_instance_t :
     void render(const wf::render_target_t& target,
         const wf::region_t& region) override
     {
+        if (render_linear_transformer_chain(self, target, region))
+        {
+            release_inner_content();
+            return;
+        }
+
         // Untransformed bounding box
         auto bbox = self->get_children_bounding_box();
         auto tex  = this->get_texture(target.scale);
-
-        auto midpoint  = get_center(self->view->get_wm_geometry());
-        auto center_at = glm::translate(glm::mat4(1.0),
-            {-midpoint.x, -midpoint.y, 0.0});
-        auto scale = glm::scale(glm::mat4(1.0),
-            glm::vec3{self->scale_x, self->scale_y, 1.0});
-        auto rotate = glm::rotate<float>(glm::mat4(1.0), -self->angle,
-            glm::vec3{0.0, 0.0, 1.0});
-        auto translate = glm::translate(glm::mat4(1.0),
-            glm::vec3{self->translation_x + midpoint.x,
-                self->translation_y + midpoint.y, 0.0});
-        auto ortho = target.get_orthographic_projection();
-        auto full_matrix = ortho * translate * rotate * scale * center_at;
+        auto full_matrix = target.get_orthographic_projection() *
+            self->get_linear_transform();
 
         OpenGL::render_begin(target);
         for (auto& box : region)
         {
             target.logic_scissor(wlr_box_from_pixman_box(box));
-            // OpenGL::clear({1, 0, 0, 1});
             OpenGL::render_transformed_texture(tex, bbox, full_matrix,
-                glm::vec4{1.0, 1.0, 1.0, self->alpha});
+                self->get_color_multiplier());
         }
 
         OpenGL::render_end();
@@ -333,6 +409,35 @@ wf::geometry_t view_3d_transformer_t::get_bounding_box()
     return get_bbox_for_node(this, get_children_bounding_box());
 }
 
+glm::mat4 view_3d_transformer_t::get_linear_transform()
+{
+    // The total transform works in coordinates relative to the center of the
+    // view, with the y axis pointing up. Convert to them and back, as in
+    // to_global(), but keep the result homogeneous.
+    auto center = get_center(get_children_bounding_box());
+    glm::mat4 to_relative{1.0};
+    to_relative[1][1] = -1.0;
+    to_relative[3][0] = -center.x;
+    to_relative[3][1] = center.y;
+
+    glm::mat4 from_relative{1.0};
+    from_relative[1][1] = -1.0;
+    from_relative[3][0] = center.x;
+    from_relative[3][1] = center.y;
+
+    return from_relative * calculate_total_transform() * to_relative;
+}
+
+glm::vec4 view_3d_transformer_t::get_color_multiplier()
+{
+    return color;
+}
+
+bool view_3d_transformer_t::is_linear_only()
+{
+    return typeid(*this) == typeid(view_3d_transformer_t);
+}
+
 struct transformable_quad
 {
     gl_geometry geometry;
@@ -378,6 +483,12 @@ class view_3d_render_instance_t :
     void render(const wf::render_target_t& target,
         const wf::region_t& damage) override
     {
+        if (render_linear_transformer_chain(self, target, damage))
+        {
+            release_inner_content();
+            return;
+        }
+
         auto bbox = self->get_children_bounding_box();
         auto quad = center_geometry(target.geometry, bbox, scene::get_center(bbox));
 
@@ -314,6 +314,9 @@ void wf::wlr_view_t::map(wlr_surface *surface)
 void wf::wlr_view_t::unmap()
 {
     damage();
+    /* Clients usually destroy the toplevel in the same dispatch, and the view
+     * may be destroyed before the next repaint would flush its damage. */
+    flush_view_damage(self());
     emit_view_pre_unmap();
 
     destroy_toplevel();
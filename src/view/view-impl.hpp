@@ -18,6 +18,26 @@
 struct wlr_seat;
 namespace wf
 {
+namespace scene
+{
+/**
+ * The root node of a view's subtree. It contains the view's transformers, the
+ * view itself and the root nodes of its child views, none of which accept
+ * input outside of their bounding box.
+ */
+class view_root_node_t : public floating_inner_node_t
+{
+  public:
+    view_root_node_t() : floating_inner_node_t(false)
+    {}
+
+    bool has_bounded_input() const override
+    {
+        return true;
+    }
+};
+}
+
 /** Private data used by the default view_interface_t implementation */
 class view_interface_t::view_priv_impl
 {
@@ -69,6 +89,12 @@ class view_interface_t::view_priv_impl
     std::shared_ptr<scene::view_node_t> surface_root_node;
     bool actually_minimized = false;
 
+    /**
+     * Damage recorded by view_damage_raw() which has not been propagated to
+     * the scenegraph yet, see flush_view_damage().
+     */
+    std::vector<wlr_box> dirty_boxes;
+
   private:
     /** Last geometry the view has had in non-tiled and non-fullscreen state.
      * -1 as width/height means that no such geometry has been stored. */
@@ -93,6 +119,17 @@ class view_interface_t::view_priv_impl
  */
 void view_damage_raw(wayfire_view view, const wlr_box& box);
 
+/**
+ * view_damage_raw() only records the damaged boxes on the view and schedules
+ * a repaint of its output. The recorded boxes are merged into a single region
+ * and propagated through the scenegraph once per frame, when this function is
+ * called just before an output is repainted.
+ */
+void flush_view_damage();
+
+/** Propagate the recorded damage of a single view immediately. */
+void flush_view_damage(wayfire_view view);
+
 /**
  * Implementation of a view backed by a wlr_* shell struct.
  */
@@ -219,6 +256,11 @@ class wlr_view_t :
     {
         _simple_render(fb, x, y, damage);
     }
+
+    virtual std::optional<wf::texture_t> get_texture() override
+    {
+        return _get_texture();
+    }
 };
 
 /** Emit the map signal for the given view */
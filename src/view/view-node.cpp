@@ -16,6 +16,7 @@
 #include "wayfire/workspace-manager.hpp"
 #include "wlr-layer-shell-unstable-v1-protocol.h"
 #include "view-impl.hpp"
+#include "../core/scene-priv.hpp"
 
 wf::scene::view_node_t::view_node_t(wayfire_view _view) :
     floating_inner_node_t(false), view(_view)
@@ -226,11 +227,8 @@ class view_render_instance_t : public render_instance_t
                 auto surface_offset = wf::origin(view->get_output_geometry());
                 damage += -surface_offset;
                 our_target.geometry = our_target.geometry + -surface_offset;
-                for (auto& ch : this->children)
-                {
-                    ch->schedule_instructions(instructions, our_target, damage);
-                }
-
+                schedule_instructions_culled(children, instructions, our_target,
+                    damage);
                 damage += surface_offset;
             }
         }
@@ -347,7 +345,6 @@ void view_node_t::gen_render_instances(std::vector<render_instance_uptr> & insta
 std::optional<wf::texture_t> view_node_t::to_texture() const
 {
     if (view->is_mapped() &&
-        !view->has_transformer() &&
         view->get_wlr_surface() &&
         (this->get_children().size() == 1))
     {
@@ -17,6 +17,7 @@
 #include <algorithm>
 #include <glm/glm.hpp>
 #include "wayfire/signal-definitions.hpp"
+#include "../core/scene-priv.hpp"
 #include <wayfire/scene-operations.hpp>
 
 static void reposition_relative_to_parent(wayfire_view view)
@@ -191,6 +192,9 @@ wayfire_view wf::view_interface_t::self()
 /** Set the view's output. */
 void wf::view_interface_t::set_output(wf::output_t *new_output)
 {
+    /* Damage recorded so far is relative to the old output */
+    flush_view_damage(self());
+
     /* Make sure the view doesn't stay on the old output */
     if (get_output() && (get_output() != new_output))
     {
@@ -810,6 +814,7 @@ const wf::render_target_t& wf::view_interface_t::take_snapshot()
     }
 
     OpenGL::render_begin();
+    offscreen_buffer.owner = "view-snapshot";
     offscreen_buffer.allocate(scaled_width, scaled_height);
     offscreen_buffer.scale = scale;
     offscreen_buffer.bind();
@@ -864,7 +869,7 @@ void wf::view_interface_t::unref()
 
 void wf::view_interface_t::initialize()
 {
-    view_impl->root_node = std::make_shared<scene::floating_inner_node_t>(false);
+    view_impl->root_node = std::make_shared<scene::view_root_node_t>();
     view_impl->transformed_node =
         std::make_shared<scene::transform_manager_node_t>();
     view_impl->surface_root_node = std::make_shared<scene::view_node_t>(this);
@@ -915,7 +920,15 @@ void wf::view_interface_t::damage_surface_box(const wlr_box& box)
     view_damage_raw(self(), damaged);
 }
 
-void wf::view_damage_raw(wayfire_view view, const wlr_box& box)
+/* Views with recorded damage which has not been flushed yet. Views remove
+ * themselves when they are destroyed. */
+static std::vector<wayfire_view> dirty_views;
+
+/* Once a view has this many dirty boxes, they are merged into one */
+static constexpr size_t MAX_DIRTY_BOXES = 16;
+
+/* Propagate the damage of a view through the scenegraph. */
+static void emit_view_damage(wayfire_view view, const wf::region_t& damage)
 {
     auto output = view->get_output();
     if (!output)
@@ -934,7 +947,7 @@ void wf::view_damage_raw(wayfire_view view, const wlr_box& box)
         /* Damage only the visible region of the shell view.
          * This prevents hidden panels from spilling damage onto other workspaces */
         wlr_box ws_box = output->get_relative_geometry();
-        wlr_box visible_damage = geometry_intersection(box, ws_box);
+        wf::region_t visible_damage = damage & ws_box;
         for (int i = 0; i < wsize.width; i++)
         {
             for (int j = 0; j < wsize.height; j++)
@@ -946,7 +959,7 @@ void wf::view_damage_raw(wayfire_view view, const wlr_box& box)
         }
     } else
     {
-        data.region |= box;
+        data.region = damage;
     }
 
     view->get_transformed_node()->emit(&data);
@@ -956,8 +969,105 @@ void wf::view_damage_raw(wayfire_view view, const wlr_box& box)
     view->emit_signal("region-damaged", nullptr);
 }
 
+void wf::view_damage_raw(wayfire_view view, const wlr_box& box)
+{
+    auto output = view->get_output();
+    if (!output || (box.width <= 0) || (box.height <= 0))
+    {
+        return;
+    }
+
+    auto& boxes = view->view_impl->dirty_boxes;
+    wf::get_core().scene()->priv->recorded_damage_boxes++;
+
+    // Damage usually means that the view has moved or changed its size.
+    // Bounding boxes are used for input, so they cannot wait for the flush.
+    view->get_transformed_node()->invalidate_bounding_box();
+    view->get_surface_root_node()->invalidate_bounding_box();
+
+    if (boxes.empty())
+    {
+        dirty_views.push_back(view);
+        // The damage reaches the output only when it is flushed before the
+        // next repaint, so make sure there is one.
+        wlr_output_schedule_frame(output->handle);
+    }
+
+    // Clients commit the same boxes over and over, skip those which are
+    // already covered.
+    for (auto& dirty : boxes)
+    {
+        if (wf::geometry_intersection(dirty, box) == box)
+        {
+            return;
+        }
+    }
+
+    if (boxes.size() < MAX_DIRTY_BOXES)
+    {
+        boxes.push_back(box);
+        return;
+    }
+
+    // No frame has flushed the damage for a while, for example because the
+    // output is off. Keep only the extents, so that recording stays cheap.
+    wf::region_t extents{box};
+    for (auto& dirty : boxes)
+    {
+        extents |= dirty;
+    }
+
+    boxes = {wlr_box_from_pixman_box(extents.get_extents())};
+}
+
+void wf::flush_view_damage(wayfire_view view)
+{
+    auto& boxes = view->view_impl->dirty_boxes;
+    if (boxes.empty())
+    {
+        return;
+    }
+
+    wf::region_t damage;
+    for (auto& box : boxes)
+    {
+        damage |= box;
+    }
+
+    // Damage emitted in response is recorded again, and the view is added
+    // back to the list.
+    boxes.clear();
+    dirty_views.erase(std::remove(dirty_views.begin(), dirty_views.end(), view),
+        dirty_views.end());
+    wf::get_core().scene()->priv->flushed_damage_views++;
+    emit_view_damage(view, damage);
+}
+
+void wf::flush_view_damage()
+{
+    // Propagating damage may cause more damage, for example when plugins
+    // damage other views in response. Give it a few rounds, anything left
+    // after that is flushed before the next repaint.
+    for (int round = 0; round < 3 && !dirty_views.empty(); round++)
+    {
+        // Flushing may destroy views, which then remove themselves from the
+        // list, so do not keep a copy of it.
+        size_t count = dirty_views.size();
+        while ((count-- > 0) && !dirty_views.empty())
+        {
+            flush_view_damage(dirty_views.front());
+        }
+    }
+}
+
 void wf::view_interface_t::destruct()
 {
+    // Damage recorded since the last frame, for example when the view was
+    // unmapped and destroyed in the same dispatch, must still reach the output.
+    flush_view_damage(self());
+    view_impl->dirty_boxes.clear();
+    dirty_views.erase(std::remove(dirty_views.begin(), dirty_views.end(), self()),
+        dirty_views.end());
     view_impl->is_alive = false;
     wf::get_core_impl().erase_view(self());
 }
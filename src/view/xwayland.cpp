@@ -933,6 +933,12 @@ class wayfire_dnd_xwayland_view : public wayfire_unmanaged_xwayland_view
         return xwayland_view_type_t::DND;
     }
 
+    std::optional<wf::texture_t> get_texture() override
+    {
+        // Drag icons need a frame callback after each render.
+        return {};
+    }
+
     void simple_render(const wf::render_target_t& fb,
         int x, int y, const wf::region_t& damage) override
     {
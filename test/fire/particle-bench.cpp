@@ -0,0 +1,54 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include <chrono>
+#include <iostream>
+#include <random>
+#include "../../plugins/animate/fire/particle.hpp"
+
+/**
+ * Spawn @size particles and update them until all have died.
+ *
+ * @return The number of particle updates per millisecond.
+ */
+static double measure_particles_per_ms(int size)
+{
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<float> dist(0, 1);
+
+    ParticleSystem system{size};
+    system.set_initer([&] (Particle& p)
+    {
+        p.life  = 1;
+        p.fade  = 0.1 + 0.5 * dist(gen);
+        p.color = {dist(gen), dist(gen), dist(gen), 1};
+        p.pos   = {1000 * dist(gen), 1000 * dist(gen)};
+        p.start_pos = p.pos;
+        p.speed     = {20 * dist(gen) - 10, 30 * dist(gen) - 25};
+        p.g = {-1, -3};
+        p.base_radius = p.radius = 10;
+    });
+
+    REQUIRE(system.spawn(size) == size);
+
+    long long updated = 0;
+    auto start = std::chrono::steady_clock::now();
+    while (system.statistic() > 0)
+    {
+        updated += system.statistic();
+        system.update();
+    }
+
+    auto end = std::chrono::steady_clock::now();
+    REQUIRE(system.spawn(size) == size);
+    return updated / std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+TEST_CASE("Fire particle update throughput")
+{
+    for (int size : {10'000, 100'000, 1'000'000})
+    {
+        std::cout << size << " particles: " << measure_particles_per_ms(size) <<
+            " particles/ms" << std::endl;
+    }
+}
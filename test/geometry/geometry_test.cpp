@@ -2,6 +2,7 @@
 #include <doctest/doctest.h>
 
 #include <wayfire/geometry.hpp>
+#include <wayfire/region.hpp>
 
 TEST_CASE("Point addition")
 {
@@ -11,3 +12,51 @@ TEST_CASE("Point addition")
     using namespace wf;
     REQUIRE_EQ(a + b, wf::point_t{4, 6});
 }
+
+TEST_CASE("Region simplification")
+{
+    // A row of 10x10 rectangles with 2px gaps between them.
+    wf::region_t region;
+    for (int i = 0; i < 20; i++)
+    {
+        region |= wf::geometry_t{i * 12, 0, 10, 10};
+    }
+
+    REQUIRE(region.rect_count() == 20);
+
+    SUBCASE("No merging")
+    {
+        auto copy = region;
+        copy.simplify(0.0);
+        REQUIRE(copy.rect_count() == 20);
+    }
+
+    SUBCASE("Merge with small overhead")
+    {
+        auto copy = region;
+        copy.simplify(0.25);
+        REQUIRE(copy.rect_count() == 1);
+        REQUIRE((copy ^ region).rect_count() == 19);
+    }
+
+    SUBCASE("Overhead threshold is respected")
+    {
+        auto copy = region;
+        copy.simplify(0.1);
+        REQUIRE(copy.rect_count() == 10);
+    }
+
+    SUBCASE("Cap the number of rectangles")
+    {
+        wf::region_t sparse;
+        for (int i = 0; i < 20; i++)
+        {
+            sparse |= wf::geometry_t{i * 100, i * 100, 10, 10};
+        }
+
+        auto copy = sparse;
+        copy.simplify(0.0, 4);
+        REQUIRE(copy.rect_count() <= 4);
+        REQUIRE((sparse ^ copy).empty());
+    }
+}
@@ -1,5 +1,6 @@
 #include "mock-core.hpp"
 #include <wayfire/output-layout.hpp>
+#include <wayfire/scene.hpp>
 #include <wayfire/touch/touch.hpp>
 
 #include "../src/core/seat/seat.hpp"
@@ -150,7 +151,9 @@ void mock_core_t::move_view_to_output(wayfire_view v,
 {}
 
 mock_core_t::mock_core_t()
-{}
+{
+    this->scene_root = std::make_shared<wf::scene::root_node_t>();
+}
 mock_core_t::~mock_core_t() = default;
 
 wf::compositor_core_impl_t& wf::compositor_core_impl_t::get()
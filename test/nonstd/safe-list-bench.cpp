@@ -0,0 +1,116 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include <chrono>
+#include <iostream>
+#include <list>
+#include <wayfire/nonstd/safe-list.hpp>
+
+static constexpr int NUM_ITERATIONS = 100'000;
+
+/**
+ * The list as it was before it was backed by a vector, used as a reference:
+ * a std::list of heap-allocated elements, where removed elements are reset and
+ * erased later. The idle cleanup is replaced by an explicit cleanup() call
+ * after each iteration.
+ */
+template<class T>
+class reference_list_t
+{
+  public:
+    void push_back(T value)
+    {
+        list.push_back(std::make_unique<T>(std::move(value)));
+    }
+
+    template<class Func>
+    void for_each(Func func)
+    {
+        auto it = list.begin();
+        for (int size = list.size(); size > 0; size--, it++)
+        {
+            if (*it)
+            {
+                func(**it);
+            }
+        }
+    }
+
+    void remove_all(const T& value)
+    {
+        for (auto& it : list)
+        {
+            if (it && (*it == value))
+            {
+                it = nullptr;
+            }
+        }
+    }
+
+    void cleanup()
+    {
+        list.remove(nullptr);
+    }
+
+  private:
+    std::list<std::unique_ptr<T>> list;
+};
+
+/**
+ * Iterate over a list of @size elements. If @mutate is set, every element
+ * removes itself and adds a new element during the iteration, as happens for
+ * example with one-shot hooks which re-arm themselves.
+ */
+template<class List>
+static double measure_ns_per_iteration(int size, bool mutate)
+{
+    List list;
+    for (int i = 0; i < size; i++)
+    {
+        list.push_back(i);
+    }
+
+    long long sum = 0;
+    int next = size;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < NUM_ITERATIONS; i++)
+    {
+        list.for_each([&] (int& x)
+        {
+            sum += x;
+            if (mutate)
+            {
+                list.remove_all(x);
+                list.push_back(next++);
+            }
+        });
+
+        if constexpr (!std::is_same_v<List, wf::safe_list_t<int>>)
+        {
+            list.cleanup();
+        }
+    }
+
+    auto end = std::chrono::steady_clock::now();
+    REQUIRE(sum > 0);
+    return std::chrono::duration<double, std::nano>(end - start).count() /
+           NUM_ITERATIONS;
+}
+
+TEST_CASE("Safe list iteration throughput")
+{
+    for (bool mutate : {false, true})
+    {
+        for (int size : {4, 16, 64})
+        {
+            double reference =
+                measure_ns_per_iteration<reference_list_t<int>>(size, mutate);
+            double current =
+                measure_ns_per_iteration<wf::safe_list_t<int>>(size, mutate);
+
+            std::cout << size << " elements" << (mutate ? " with mutation" : "") <<
+                ": reference " << reference << " ns/iteration, vector " <<
+                current << " ns/iteration" << std::endl;
+        }
+    }
+}
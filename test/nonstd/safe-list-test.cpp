@@ -0,0 +1,148 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include <wayfire/nonstd/safe-list.hpp>
+#include <vector>
+
+using list_t = wf::safe_list_t<int>;
+
+static std::vector<int> contents(const list_t& list)
+{
+    std::vector<int> result;
+    list.for_each([&] (int& x) { result.push_back(x); });
+    return result;
+}
+
+TEST_CASE("Basic operations")
+{
+    list_t list;
+    list.push_back(1);
+    list.push_back(2);
+    list.emplace_back(3);
+    REQUIRE(list.size() == 3);
+    REQUIRE(list.back() == 3);
+    REQUIRE(contents(list) == std::vector<int>{1, 2, 3});
+
+    std::vector<int> reversed;
+    list.for_each_reverse([&] (int& x) { reversed.push_back(x); });
+    REQUIRE(reversed == std::vector<int>{3, 2, 1});
+
+    list.remove_all(2);
+    REQUIRE(list.size() == 2);
+    REQUIRE(contents(list) == std::vector<int>{1, 3});
+
+    list.clear();
+    REQUIRE(list.size() == 0);
+    REQUIRE_THROWS(list.back());
+}
+
+TEST_CASE("Insert at a position")
+{
+    list_t list;
+    auto sorted = [] (int value)
+    {
+        return [=] (int& x)
+        {
+            return x > value ? list_t::INSERT_BEFORE : list_t::INSERT_NONE;
+        };
+    };
+
+    list.insert_at(5, sorted(5));
+    list.insert_at(1, sorted(1));
+    list.insert_at(3, sorted(3));
+    list.insert_at(7, sorted(7));
+    REQUIRE(contents(list) == std::vector<int>{1, 3, 5, 7});
+
+    list.insert_at(4, [] (int& x)
+    {
+        return x == 3 ? list_t::INSERT_AFTER : list_t::INSERT_NONE;
+    });
+    REQUIRE(contents(list) == std::vector<int>{1, 3, 4, 5, 7});
+}
+
+TEST_CASE("Mutation during iteration")
+{
+    list_t list;
+    for (int i = 0; i < 5; i++)
+    {
+        list.push_back(i);
+    }
+
+    std::vector<int> visited;
+    list.for_each([&] (int& x)
+    {
+        visited.push_back(x);
+        if (x == 1)
+        {
+            // Removed elements are skipped, added ones are visited from the
+            // next iteration on.
+            list.remove_all(3);
+            list.push_back(10);
+            list.insert_at(-1, [] (int&) { return list_t::INSERT_BEFORE; });
+            REQUIRE(list.size() == 6);
+            REQUIRE(list.back() == -1);
+        }
+
+        if (x == 4)
+        {
+            list.remove_all(4);
+        }
+
+        // The element is still valid after modifying the list.
+        REQUIRE(x == visited.back());
+    });
+
+    REQUIRE(visited == std::vector<int>{0, 1, 2, 4});
+    REQUIRE(list.size() == 5);
+    REQUIRE(contents(list) == std::vector<int>{-1, 0, 1, 2, 10});
+}
+
+TEST_CASE("Nested iteration")
+{
+    list_t list;
+    list.push_back(1);
+    list.push_back(2);
+
+    std::vector<int> inner;
+    list.for_each([&] (int& x)
+    {
+        if (x == 1)
+        {
+            list.push_back(3);
+            list.remove_all(2);
+            // A nested iteration sees the list as it is now.
+            list.for_each([&] (int& y) { inner.push_back(y); });
+        }
+    });
+
+    REQUIRE(inner == std::vector<int>{1, 3});
+    REQUIRE(contents(list) == std::vector<int>{1, 3});
+}
+
+TEST_CASE("Iteration ends when the callback throws")
+{
+    list_t list;
+    list.push_back(1);
+    list.push_back(2);
+
+    REQUIRE_THROWS(list.for_each([&] (int&)
+    {
+        list.remove_all(1);
+        list.push_back(3);
+        throw std::runtime_error("error");
+    }));
+
+    REQUIRE(contents(list) == std::vector<int>{2, 3});
+}
+
+TEST_CASE("Copying a list")
+{
+    list_t list;
+    list.push_back(1);
+    list.push_back(2);
+
+    list_t copy = list;
+    list.remove_all(1);
+    REQUIRE(contents(copy) == std::vector<int>{1, 2});
+    REQUIRE(contents(list) == std::vector<int>{2});
+}
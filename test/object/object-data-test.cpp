@@ -0,0 +1,85 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include <wayfire/object.hpp>
+
+struct test_object_t : public wf::object_base_t
+{};
+
+template<int N>
+struct data_t : public wf::custom_data_t
+{
+    int value = N;
+};
+
+TEST_CASE("Typed custom data")
+{
+    test_object_t object;
+    REQUIRE_FALSE(object.has_data<data_t<0>>());
+    REQUIRE(object.get_data<data_t<0>>() == nullptr);
+
+    auto data = object.get_data_safe<data_t<0>>();
+    REQUIRE(data != nullptr);
+    REQUIRE(object.has_data<data_t<0>>());
+    REQUIRE(object.get_data<data_t<0>>() == data);
+
+    object.store_data(std::make_unique<data_t<1>>());
+    REQUIRE(object.get_data<data_t<1>>()->value == 1);
+
+    auto released = object.release_data<data_t<1>>();
+    REQUIRE(released->value == 1);
+    REQUIRE_FALSE(object.has_data<data_t<1>>());
+
+    object.erase_data<data_t<0>>();
+    REQUIRE_FALSE(object.has_data<data_t<0>>());
+}
+
+TEST_CASE("Typed and named custom data are the same")
+{
+    test_object_t object;
+    object.store_data(std::make_unique<data_t<2>>(), typeid(data_t<2>).name());
+    REQUIRE(object.get_data<data_t<2>>()->value == 2);
+
+    object.get_data_safe<data_t<3>>()->value = 30;
+    REQUIRE(object.get_data<data_t<3>>(typeid(data_t<3>).name())->value == 30);
+
+    object.store_data(std::make_unique<data_t<4>>(), "custom-name");
+    REQUIRE(object.has_data("custom-name"));
+    REQUIRE_FALSE(object.has_data<data_t<4>>());
+    object.erase_data("custom-name");
+    REQUIRE_FALSE(object.has_data("custom-name"));
+}
+
+TEST_CASE("More data than inline slots")
+{
+    test_object_t object;
+    object.get_data_safe<data_t<10>>();
+    object.get_data_safe<data_t<11>>();
+    object.get_data_safe<data_t<12>>();
+    object.get_data_safe<data_t<13>>();
+    object.get_data_safe<data_t<14>>();
+    object.get_data_safe<data_t<15>>();
+
+    REQUIRE(object.get_data<data_t<10>>()->value == 10);
+    REQUIRE(object.get_data<data_t<15>>()->value == 15);
+
+    object.erase_data<data_t<10>>();
+    object.erase_data<data_t<15>>();
+    REQUIRE_FALSE(object.has_data<data_t<10>>());
+    REQUIRE_FALSE(object.has_data<data_t<15>>());
+    REQUIRE(object.get_data<data_t<14>>()->value == 14);
+
+    // Freed inline slots are reused.
+    object.store_data(std::make_unique<data_t<16>>());
+    REQUIRE(object.get_data<data_t<16>>()->value == 16);
+}
+
+TEST_CASE("Replacing stored data")
+{
+    test_object_t object;
+    auto first = std::make_unique<data_t<5>>();
+    first->value = 50;
+    object.store_data(std::move(first));
+    object.store_data(std::make_unique<data_t<5>>());
+    REQUIRE(object.get_data<data_t<5>>()->value == 5);
+}
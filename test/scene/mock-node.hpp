@@ -0,0 +1,71 @@
+#pragma once
+
+#include <wayfire/scene.hpp>
+
+/**
+ * A leaf node which accepts input inside a rectangle, similar to a mapped
+ * surface.
+ */
+class mock_box_node_t : public wf::scene::node_t
+{
+  public:
+    wf::geometry_t box;
+
+    mock_box_node_t(wf::geometry_t box) : node_t(false), box(box)
+    {}
+
+    std::optional<wf::scene::input_node_t> find_node_at(
+        const wf::pointf_t& at) override
+    {
+        if (box & at)
+        {
+            wf::scene::input_node_t result;
+            result.node    = this;
+            result.surface = nullptr;
+            result.local_coords = at;
+            return result;
+        }
+
+        return {};
+    }
+
+    wf::geometry_t get_bounding_box() override
+    {
+        return box;
+    }
+
+    bool has_bounded_input() const override
+    {
+        return true;
+    }
+
+    /** Move the node, emitting damage like a real surface would do. */
+    void set_box(wf::geometry_t new_box)
+    {
+        wf::scene::node_damage_signal data;
+        data.region |= box;
+        box = new_box;
+        data.region |= box;
+        this->emit(&data);
+    }
+};
+
+/**
+ * A node which accepts input everywhere, like an input grab.
+ */
+class mock_grab_node_t : public wf::scene::node_t
+{
+  public:
+    mock_grab_node_t() : node_t(false)
+    {}
+
+    std::optional<wf::scene::input_node_t> find_node_at(
+        const wf::pointf_t& at) override
+    {
+        wf::scene::input_node_t result;
+        result.node    = this;
+        result.surface = nullptr;
+        result.local_coords = at;
+        return result;
+    }
+};
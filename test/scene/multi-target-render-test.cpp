@@ -0,0 +1,78 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include <wayfire/scene.hpp>
+#include <wayfire/scene-render.hpp>
+
+using namespace wf::scene;
+
+struct render_call_t
+{
+    wf::geometry_t target;
+    wf::geometry_t damage;
+};
+
+/**
+ * A render instance which schedules itself with a translated target, like
+ * views with a surface offset, and records the calls to render().
+ */
+class offset_render_instance_t : public render_instance_t
+{
+  public:
+    wf::geometry_t box;
+    wf::point_t offset;
+    std::vector<render_call_t> calls;
+
+    void schedule_instructions(std::vector<render_instruction_t>& instructions,
+        const wf::render_target_t& target, wf::region_t& damage) override
+    {
+        auto our_target = target;
+        our_target.geometry = target.geometry + -offset;
+        auto our_damage = (damage + -offset) & box;
+        if (!our_damage.empty())
+        {
+            instructions.push_back({this, our_target, our_damage});
+        }
+    }
+
+    void render(const wf::render_target_t& target,
+        const wf::region_t& region) override
+    {
+        calls.push_back({target.geometry,
+            wlr_box_from_pixman_box(region.get_extents())});
+    }
+};
+
+TEST_CASE("Multi-target passes keep the translation of instruction targets")
+{
+    // A box from x=950 to x=1050 in the parent, across two workspaces
+    auto instance = std::make_unique<offset_render_instance_t>();
+    instance->offset = {10, 20};
+    instance->box    = {940, 0, 100, 100};
+    auto ptr = instance.get();
+
+    std::vector<render_instance_uptr> instances;
+    instances.push_back(std::move(instance));
+
+    std::vector<render_pass_target_t> targets(2);
+    targets[0].target.geometry = {0, 0, 1000, 1000};
+    targets[1].target.geometry = {1000, 0, 1000, 1000};
+    for (auto& t : targets)
+    {
+        t.damage |= t.target.geometry;
+    }
+
+    run_multi_target_render_pass(instances, targets, nullptr, 0);
+
+    REQUIRE(ptr->calls.size() == 2);
+    CHECK(ptr->calls[0].target == wf::geometry_t{-10, -20, 1000, 1000});
+    CHECK(ptr->calls[0].damage == wf::geometry_t{940, 0, 50, 100});
+    CHECK(ptr->calls[1].target == wf::geometry_t{990, -20, 1000, 1000});
+    CHECK(ptr->calls[1].damage == wf::geometry_t{990, 0, 50, 100});
+
+    // The repainted damage is reported per target
+    for (auto& t : targets)
+    {
+        CHECK(wlr_box_from_pixman_box(t.damage.get_extents()) == t.target.geometry);
+    }
+}
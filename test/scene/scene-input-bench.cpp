@@ -0,0 +1,99 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include <chrono>
+#include <iostream>
+#include <random>
+#include <wayfire/scene.hpp>
+#include "mock-node.hpp"
+
+using namespace wf::scene;
+
+static constexpr int OUTPUT_WIDTH  = 3840;
+static constexpr int OUTPUT_HEIGHT = 2160;
+static constexpr int NUM_QUERIES   = 100'000;
+
+/**
+ * The hit-test as it was done before bounding box caching and spatial
+ * indexing, used as a reference.
+ */
+static std::optional<input_node_t> find_node_linear(node_ptr root,
+    const wf::pointf_t& at)
+{
+    for (auto& ch : root->get_children())
+    {
+        if (ch->is_enabled())
+        {
+            if (auto result = ch->find_node_at(at))
+            {
+                return result;
+            }
+        }
+    }
+
+    return {};
+}
+
+template<class Func>
+static double measure_ns_per_query(const std::vector<wf::pointf_t>& points,
+    Func find)
+{
+    size_t hits = 0;
+    auto start  = std::chrono::steady_clock::now();
+    for (auto& p : points)
+    {
+        hits += find(p).has_value();
+    }
+
+    auto end = std::chrono::steady_clock::now();
+    REQUIRE(hits <= points.size());
+    return std::chrono::duration<double, std::nano>(end - start).count() /
+           points.size();
+}
+
+TEST_CASE("Pointer motion hit-testing cost")
+{
+    std::mt19937 gen(42);
+    std::uniform_int_distribution<int> size(200, 1000);
+    std::uniform_real_distribution<double> x(0, OUTPUT_WIDTH);
+    std::uniform_real_distribution<double> y(0, OUTPUT_HEIGHT);
+
+    std::vector<wf::pointf_t> points;
+    for (int i = 0; i < NUM_QUERIES; i++)
+    {
+        points.push_back({x(gen), y(gen)});
+    }
+
+    for (int count : {10, 100, 1000})
+    {
+        auto layer = std::make_shared<floating_inner_node_t>(false);
+        std::vector<node_ptr> children;
+        for (int i = 0; i < count; i++)
+        {
+            wf::geometry_t box = {(int)x(gen), (int)y(gen), size(gen), size(gen)};
+            children.push_back(std::make_shared<mock_box_node_t>(box));
+        }
+
+        layer->set_children_list(children);
+
+        double linear = measure_ns_per_query(points,
+            [&] (auto p) { return find_node_linear(layer, p); });
+        double indexed = measure_ns_per_query(points,
+            [&] (auto p) { return layer->find_node_at(p); });
+
+        // Both methods must agree on the result
+        for (int i = 0; i < 1000; i++)
+        {
+            auto a = find_node_linear(layer, points[i]);
+            auto b = layer->find_node_at(points[i]);
+            REQUIRE(a.has_value() == b.has_value());
+            if (a)
+            {
+                REQUIRE(a->node == b->node);
+            }
+        }
+
+        std::cout << count << " views: linear " << linear << " ns/motion, "
+                  << "indexed " << indexed << " ns/motion" << std::endl;
+    }
+}
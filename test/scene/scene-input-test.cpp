@@ -0,0 +1,84 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include <wayfire/scene.hpp>
+#include "mock-node.hpp"
+
+using namespace wf::scene;
+
+static std::shared_ptr<floating_inner_node_t> make_grid_layer(int count,
+    std::vector<std::shared_ptr<mock_box_node_t>>& nodes)
+{
+    auto layer = std::make_shared<floating_inner_node_t>(false);
+    std::vector<node_ptr> children;
+    for (int i = 0; i < count; i++)
+    {
+        // Overlapping boxes, every box is 50px to the right of the previous.
+        auto node = std::make_shared<mock_box_node_t>(
+            wf::geometry_t{i * 50, 0, 100, 100});
+        nodes.push_back(node);
+        children.push_back(node);
+    }
+
+    layer->set_children_list(children);
+    return layer;
+}
+
+static node_t *hit(node_ptr root, wf::pointf_t at)
+{
+    auto result = root->find_node_at(at);
+    return result ? result->node.get() : nullptr;
+}
+
+TEST_CASE("Hit-testing returns the topmost node")
+{
+    for (int count : {4, 64})
+    {
+        std::vector<std::shared_ptr<mock_box_node_t>> nodes;
+        auto layer = make_grid_layer(count, nodes);
+
+        // First child is the topmost one
+        REQUIRE(hit(layer, {75, 50}) == nodes[0].get());
+        REQUIRE(hit(layer, {125, 50}) == nodes[1].get());
+        REQUIRE(hit(layer, {-10, 50}) == nullptr);
+        REQUIRE(hit(layer, {10, 150}) == nullptr);
+
+        set_node_enabled(nodes[0], false);
+        REQUIRE(hit(layer, {75, 50}) == nodes[1].get());
+        set_node_enabled(nodes[0], true);
+        REQUIRE(hit(layer, {75, 50}) == nodes[0].get());
+    }
+}
+
+TEST_CASE("Hit-testing follows damaged nodes")
+{
+    for (int count : {4, 64})
+    {
+        std::vector<std::shared_ptr<mock_box_node_t>> nodes;
+        auto layer = make_grid_layer(count, nodes);
+
+        REQUIRE(hit(layer, {10, 500}) == nullptr);
+        nodes[2]->set_box({0, 450, 100, 100});
+        REQUIRE(hit(layer, {10, 500}) == nodes[2].get());
+        REQUIRE(layer->get_cached_bounding_box() == layer->get_bounding_box());
+    }
+}
+
+TEST_CASE("Hit-testing does not skip nodes with unbounded input")
+{
+    for (int count : {4, 64})
+    {
+        std::vector<std::shared_ptr<mock_box_node_t>> nodes;
+        auto layer = make_grid_layer(count, nodes);
+
+        auto children = layer->get_children();
+        auto grab     = std::make_shared<mock_grab_node_t>();
+        children.insert(children.begin() + 1, grab);
+        layer->set_children_list(children);
+
+        REQUIRE(hit(layer, {10, 50}) == nodes[0].get());
+        REQUIRE(hit(layer, {75, 50}) == nodes[0].get());
+        REQUIRE(hit(layer, {125, 50}) == grab.get());
+        REQUIRE(hit(layer, {-1000, -1000}) == grab.get());
+    }
+}
@@ -0,0 +1,131 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <list>
+#include <memory>
+#include <typeindex>
+#include <unordered_map>
+#include <wayfire/signal-provider.hpp>
+
+using namespace wf::signal;
+
+static constexpr int NUM_EMITS = 1'000'000;
+
+struct hot_signal
+{
+    int counter = 0;
+};
+
+struct cold_signal_1
+{};
+struct cold_signal_2
+{};
+
+/**
+ * The connection list of the dispatch below, as safe_list_t was implemented
+ * before it was backed by a vector: a std::list of heap-allocated elements,
+ * iterated with a std::function callback. It is copied here, so that the
+ * reference does not change along with safe_list_t.
+ */
+template<class T>
+class reference_list_t
+{
+  public:
+    void push_back(T value)
+    {
+        list.push_back(std::make_unique<T>(std::move(value)));
+    }
+
+    void for_each(std::function<void(T&)> func) const
+    {
+        auto it = list.begin();
+        for (int size = list.size(); size > 0; size--, it++)
+        {
+            if (*it)
+            {
+                func(**it);
+            }
+        }
+    }
+
+  private:
+    std::list<std::unique_ptr<T>> list;
+};
+
+/**
+ * The dispatch as it was done before type ids and connection arrays, used as
+ * a reference: a hash map lookup of the type_index, iteration over the old
+ * list-based connection list and a dynamic_cast for every connection.
+ */
+class reference_provider_t
+{
+  public:
+    template<class SignalType>
+    void connect(connection_t<SignalType> *callback)
+    {
+        typed_connections[std::type_index(typeid(SignalType))].push_back(callback);
+    }
+
+    template<class SignalType>
+    void emit(SignalType *data)
+    {
+        auto& conns = typed_connections[std::type_index(typeid(SignalType))];
+        conns.for_each([&] (connection_base_t *tc)
+        {
+            auto real_type = dynamic_cast<connection_t<SignalType>*>(tc);
+            assert(real_type);
+            real_type->emit(data);
+        });
+    }
+
+  private:
+    std::unordered_map<std::type_index, reference_list_t<connection_base_t*>>
+    typed_connections;
+};
+
+template<class Provider>
+static double measure_ns_per_emit(int nr_connections)
+{
+    Provider provider;
+    std::vector<std::unique_ptr<connection_t<hot_signal>>> conns;
+    for (int i = 0; i < nr_connections; i++)
+    {
+        conns.push_back(std::make_unique<connection_t<hot_signal>>(
+            [] (hot_signal *ev) { ev->counter++; }));
+        provider.connect(conns.back().get());
+    }
+
+    // Other signals connected to the same object, as is usual for nodes and
+    // views.
+    connection_t<cold_signal_1> cold1 = [] (cold_signal_1*) {};
+    connection_t<cold_signal_2> cold2 = [] (cold_signal_2*) {};
+    provider.connect(&cold1);
+    provider.connect(&cold2);
+
+    hot_signal ev;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < NUM_EMITS; i++)
+    {
+        provider.emit(&ev);
+    }
+
+    auto end = std::chrono::steady_clock::now();
+    REQUIRE(ev.counter == NUM_EMITS * nr_connections);
+    return std::chrono::duration<double, std::nano>(end - start).count() /
+           NUM_EMITS;
+}
+
+TEST_CASE("Signal emission throughput")
+{
+    for (int count : {1, 4, 16})
+    {
+        double reference = measure_ns_per_emit<reference_provider_t>(count);
+        double current   = measure_ns_per_emit<provider_t>(count);
+
+        std::cout << count << " connections: reference " << reference <<
+            " ns/emit, typed arrays " << current << " ns/emit" << std::endl;
+    }
+}
@@ -0,0 +1,22 @@
+#include <wayfire/signal-provider.hpp>
+
+// Has the same name as a signal in an anonymous namespace of signal-test.cpp,
+// like signals defined privately by two different plugins.
+namespace
+{
+struct private_signal
+{
+    int value = 0;
+};
+}
+
+const void *other_private_signal_id()
+{
+    return wf::signal::detail::signal_type_id<private_signal>;
+}
+
+void emit_other_private_signal(wf::signal::provider_t& provider)
+{
+    private_signal ev;
+    provider.emit(&ev);
+}
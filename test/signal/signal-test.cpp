@@ -0,0 +1,162 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include <wayfire/signal-provider.hpp>
+#include <vector>
+
+using namespace wf::signal;
+
+struct signal_a
+{
+    int value = 0;
+};
+
+struct signal_b
+{
+    int value = 0;
+};
+
+namespace other
+{
+struct signal_a
+{};
+}
+
+namespace
+{
+struct private_signal
+{
+    int value = 0;
+};
+}
+
+/* Defined in signal-test-other.cpp for its own private_signal */
+const void *other_private_signal_id();
+void emit_other_private_signal(provider_t& provider);
+
+TEST_CASE("Signal type ids are distinct")
+{
+    REQUIRE(detail::signal_type_id<signal_a> != detail::signal_type_id<signal_b>);
+    REQUIRE(detail::signal_type_id<signal_a> !=
+        detail::signal_type_id<other::signal_a>);
+    REQUIRE(detail::signal_type_id<private_signal> != other_private_signal_id());
+}
+
+TEST_CASE("Signals in anonymous namespaces of different files do not mix")
+{
+    provider_t provider;
+    int calls = 0;
+    connection_t<private_signal> conn = [&] (private_signal*) { calls++; };
+    provider.connect(&conn);
+
+    emit_other_private_signal(provider);
+    REQUIRE(calls == 0);
+
+    private_signal ev;
+    provider.emit(&ev);
+    REQUIRE(calls == 1);
+}
+
+TEST_CASE("Emit calls connections of the same type in order")
+{
+    provider_t provider;
+    std::vector<int> calls;
+
+    connection_t<signal_a> first = [&] (signal_a *ev)
+    {
+        calls.push_back(1 + ev->value);
+    };
+    connection_t<signal_a> second = [&] (signal_a*) { calls.push_back(2); };
+    connection_t<signal_b> other = [&] (signal_b*) { calls.push_back(3); };
+
+    provider.connect(&first);
+    provider.connect(&second);
+    provider.connect(&other);
+
+    signal_a ev;
+    ev.value = 10;
+    provider.emit(&ev);
+    REQUIRE(calls == std::vector<int>{11, 2});
+
+    calls.clear();
+    first.disconnect();
+    REQUIRE_FALSE(first.is_connected());
+    provider.emit(&ev);
+    REQUIRE(calls == std::vector<int>{2});
+}
+
+TEST_CASE("Connections may be changed during emission")
+{
+    provider_t provider;
+    std::vector<int> calls;
+
+    connection_t<signal_a> late = [&] (signal_a*) { calls.push_back(3); };
+    connection_t<signal_a> second = [&] (signal_a*) { calls.push_back(2); };
+    connection_t<signal_a> first = [&] (signal_a*)
+    {
+        calls.push_back(1);
+        // Removed connections are not called anymore, added connections are
+        // called from the next emission.
+        second.disconnect();
+        provider.connect(&late);
+    };
+
+    provider.connect(&first);
+    provider.connect(&second);
+
+    signal_a ev;
+    provider.emit(&ev);
+    REQUIRE(calls == std::vector<int>{1});
+
+    calls.clear();
+    first.disconnect();
+    provider.emit(&ev);
+    REQUIRE(calls == std::vector<int>{3});
+}
+
+TEST_CASE("Nested emissions and destroyed connections")
+{
+    provider_t provider;
+    int nested = 0;
+    int outer  = 0;
+
+    auto victim = std::make_unique<connection_t<signal_a>>();
+    *victim = [&] (signal_a*) { ++nested; };
+
+    connection_t<signal_a> first = [&] (signal_a *ev)
+    {
+        ++outer;
+        if (ev->value == 0)
+        {
+            signal_a inner;
+            inner.value = 1;
+            provider.emit(&inner);
+            victim.reset();
+        }
+    };
+
+    provider.connect(&first);
+    provider.connect(victim.get());
+
+    signal_a ev;
+    provider.emit(&ev);
+    REQUIRE(outer == 2);
+    REQUIRE(nested == 1);
+
+    ev.value = 2;
+    provider.emit(&ev);
+    REQUIRE(outer == 3);
+    REQUIRE(nested == 1);
+}
+
+TEST_CASE("Destroying a provider disconnects its connections")
+{
+    connection_t<signal_a> conn = [] (signal_a*) {};
+    {
+        provider_t provider;
+        provider.connect(&conn);
+        REQUIRE(conn.is_connected());
+    }
+
+    REQUIRE_FALSE(conn.is_connected());
+}
@@ -0,0 +1,82 @@
+#define DOCTEST_CONFIG_IMPLEMENT_WITH_MAIN
+#include <doctest/doctest.h>
+
+#include <wayfire/thread-pool.hpp>
+#include <stdexcept>
+#include <vector>
+
+TEST_CASE("parallel_for visits each index once")
+{
+    for (int workers : {0, 1, 4})
+    {
+        wf::thread_pool_t pool{workers};
+        std::vector<std::atomic<int>> visited(10007);
+        pool.parallel_for(0, visited.size(), [&] (int start, int end)
+        {
+            CHECK(start < end);
+            for (int i = start; i < end; i++)
+            {
+                ++visited[i];
+            }
+        }, 16);
+
+        for (auto& v : visited)
+        {
+            REQUIRE(v == 1);
+        }
+    }
+}
+
+TEST_CASE("Nested task groups")
+{
+    wf::thread_pool_t pool{3};
+    std::atomic<int> count{0};
+
+    {
+        wf::thread_pool_t::task_group_t group{pool};
+        for (int i = 0; i < 50; i++)
+        {
+            group.run([&]
+            {
+                wf::thread_pool_t::task_group_t inner{pool};
+                for (int j = 0; j < 20; j++)
+                {
+                    inner.run([&] { ++count; });
+                }
+
+                inner.wait();
+                CHECK(count >= 20);
+            });
+        }
+    }
+
+    REQUIRE(count == 1000);
+}
+
+TEST_CASE("Exceptions of tasks are rethrown by wait()")
+{
+    for (int workers : {0, 2})
+    {
+        wf::thread_pool_t pool{workers};
+        std::atomic<int> count{0};
+
+        wf::thread_pool_t::task_group_t group{pool};
+        for (int i = 0; i < 20; i++)
+        {
+            group.run([&, i]
+            {
+                ++count;
+                if (i == 7)
+                {
+                    throw std::runtime_error("task failed");
+                }
+            });
+        }
+
+        REQUIRE_THROWS_AS(group.wait(), std::runtime_error);
+        REQUIRE(count == 20);
+
+        // The error is reported once
+        group.wait();
+    }
+}